@@ -21,7 +21,7 @@
 #include "Device.h"
 
 #include <cstdio>
-#include <platform/CHIPDeviceLayer.h>
+#include <lib/support/logging/CHIPLogging.h>
 
 using namespace chip::app::Clusters::Actions;
 
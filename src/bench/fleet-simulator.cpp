@@ -0,0 +1,583 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <random>
+#include <string_view>
+#include <strings.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <crypto/CHIPCryptoPAL.h>
+#include <lib/support/Base64.h>
+#include <lib/support/logging/CHIPLogging.h>
+
+#include "fleet-simulator.hpp"
+
+using namespace wled::bench;
+
+namespace {
+constexpr uint8_t OPCODE_CONTINUATION = 0x0;
+constexpr uint8_t OPCODE_TEXT         = 0x1;
+constexpr uint8_t OPCODE_CLOSE        = 0x8;
+constexpr uint8_t OPCODE_PING         = 0x9;
+constexpr uint8_t OPCODE_PONG         = 0xA;
+
+constexpr uint8_t FLAG_FIN  = 0x80;
+constexpr uint8_t FLAG_MASK = 0x80;
+
+// The bridge never sends more than a command, anything bigger is a broken client
+constexpr size_t MAX_REQUEST_BYTES = 8192;
+constexpr size_t MAX_FRAME_BYTES   = 65536;
+
+constexpr const char * WEBSOCKET_GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+constexpr int MAX_EVENTS = 64;
+
+// Same shape as WLED's own segments, only used to pad pushes to the configured size
+constexpr const char * PADDING_SEGMENT = "{\"id\":%zu,\"start\":0,\"stop\":30,\"len\":30,\"grp\":1,\"spc\":0,\"of\":0,\"on\":true,"
+                                         "\"frz\":false,\"bri\":255,\"cct\":127,\"col\":[[255,160,0],[0,0,0],[0,0,0]],\"fx\":0,"
+                                         "\"sx\":128,\"ix\":128,\"pal\":0,\"sel\":false,\"rev\":false,\"mi\":false}";
+
+void append_number(std::string & out, uint32_t value)
+{
+    char buffer[12];
+    int length = snprintf(buffer, sizeof(buffer), "%u", value);
+    out.append(buffer, static_cast<size_t>(length));
+}
+
+std::string compute_accept(std::string_view key)
+{
+    std::string concatenated = std::string(key) + WEBSOCKET_GUID;
+    uint8_t digest[chip::Crypto::kSHA1_Hash_Length];
+
+    if (chip::Crypto::Hash_SHA1(reinterpret_cast<const uint8_t *>(concatenated.data()), concatenated.size(), digest) !=
+        CHIP_NO_ERROR)
+        return "";
+
+    char encoded[BASE64_ENCODED_LEN(sizeof(digest)) + 1]{};
+    uint16_t length = chip::Base64Encode(digest, sizeof(digest), encoded);
+    return std::string(encoded, length);
+}
+
+// Header names are case-insensitive, values run to the end of the line
+bool find_header(std::string_view headers, std::string_view name, std::string_view & value)
+{
+    for (size_t pos = 0; pos < headers.size();)
+    {
+        size_t eol = headers.find("\r\n", pos);
+        if (eol == std::string_view::npos)
+            eol = headers.size();
+
+        std::string_view line = headers.substr(pos, eol - pos);
+        if (line.size() > name.size() && line[name.size()] == ':' && strncasecmp(line.data(), name.data(), name.size()) == 0)
+        {
+            value = line.substr(name.size() + 1);
+            while (!value.empty() && value.front() == ' ')
+                value.remove_prefix(1);
+            while (!value.empty() && value.back() == ' ')
+                value.remove_suffix(1);
+            return true;
+        }
+        pos = eol + 2;
+    }
+    return false;
+}
+
+timespec to_timespec(std::chrono::steady_clock::time_point when)
+{
+    auto since = std::chrono::duration_cast<std::chrono::nanoseconds>(when.time_since_epoch()).count();
+    timespec result;
+    result.tv_sec  = static_cast<time_t>(since / 1000000000);
+    result.tv_nsec = static_cast<long>(since % 1000000000);
+    return result;
+}
+} // namespace
+
+FleetSimulator::FleetSimulator(const Config & aConfig) : config(aConfig)
+{
+    for (size_t i = 0; i < config.devices; i++)
+    {
+        auto light   = std::make_unique<Light>();
+        light->index = i;
+        lights.push_back(std::move(light));
+    }
+}
+
+FleetSimulator::~FleetSimulator()
+{
+    for (auto & connection : connections)
+        if (connection->fd >= 0)
+            close(connection->fd);
+    for (auto & light : lights)
+        if (light->fd >= 0)
+            close(light->fd);
+    if (timer.fd >= 0)
+        close(timer.fd);
+}
+
+bool FleetSimulator::listen()
+{
+    timer.fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer.fd < 0 || !reactor.add(timer.fd, EPOLLIN, &timer))
+    {
+        ChipLogError(DeviceLayer, "timerfd: %s", strerror(errno));
+        return false;
+    }
+
+    std::mt19937 random(std::random_device{}());
+    auto now = Clock::now();
+
+    for (auto & light : lights)
+    {
+        auto port = static_cast<uint16_t>(config.base_port + light->index);
+
+        light->fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (light->fd < 0)
+        {
+            ChipLogError(DeviceLayer, "socket: %s", strerror(errno));
+            return false;
+        }
+
+        int on = 1;
+        setsockopt(light->fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+        sockaddr_in address     = {};
+        address.sin_family      = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port        = htons(port);
+        if (bind(light->fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0 || ::listen(light->fd, 16) < 0 ||
+            !reactor.add(light->fd, EPOLLIN, light.get()))
+        {
+            ChipLogError(DeviceLayer, "Could not listen on port %u: %s", port, strerror(errno));
+            return false;
+        }
+
+        // Pad with whole segments until the push reaches the configured size
+        render(*light, document);
+        for (size_t id = 1; document.size() + light->padding.size() < config.payload_bytes; id++)
+        {
+            char segment[512];
+            int length = snprintf(segment, sizeof(segment), PADDING_SEGMENT, id);
+            light->padding += ',';
+            light->padding.append(segment, static_cast<size_t>(length));
+        }
+
+        // Spread unsolicited pushes out so the lights don't all push at the same moment
+        if (config.push_rate > 0)
+        {
+            std::uniform_real_distribution<double> phase(0, 1 / config.push_rate);
+            auto offset = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(phase(random)));
+            due.push({ now + offset, light->index, true, {} });
+        }
+    }
+
+    arm_timer();
+    return true;
+}
+
+void FleetSimulator::run()
+{
+    epoll_event events[MAX_EVENTS];
+
+    while (!stopping)
+    {
+        int ready = reactor.wait(events, MAX_EVENTS, -1);
+
+        for (int i = 0; i < ready; i++)
+        {
+            auto * handle = static_cast<Handle *>(events[i].data.ptr);
+            if (handle->fd < 0)
+                continue;
+
+            switch (handle->kind)
+            {
+            case Handle::Kind::kListener:
+                accept_all(*static_cast<Light *>(handle));
+                break;
+            case Handle::Kind::kTimer: {
+                uint64_t expirations;
+                if (read(timer.fd, &expirations, sizeof(expirations)) < 0 && errno != EAGAIN)
+                    ChipLogError(DeviceLayer, "Could not read timerfd: %s", strerror(errno));
+                fire_due();
+                break;
+            }
+            case Handle::Kind::kConnection: {
+                auto & connection = *static_cast<Connection *>(handle);
+                if (events[i].events & EPOLLOUT)
+                    writable(connection);
+                if (connection.fd >= 0 && (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)))
+                    readable(connection);
+                break;
+            }
+            }
+        }
+
+        // Only now that no event in the batch can point at them any more
+        connections.erase(std::remove_if(connections.begin(), connections.end(),
+                                         [](const std::unique_ptr<Connection> & connection) { return connection->fd < 0; }),
+                          connections.end());
+
+        arm_timer();
+    }
+}
+
+void FleetSimulator::stop()
+{
+    stopping = true;
+    reactor.wake();
+}
+
+void FleetSimulator::accept_all(Light & light)
+{
+    while (true)
+    {
+        int fd = accept4(light.fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+        {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+                ChipLogError(DeviceLayer, "accept: %s", strerror(errno));
+            if (errno != EINTR)
+                return;
+            continue;
+        }
+
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        auto connection   = std::make_unique<Connection>();
+        connection->fd    = fd;
+        connection->light = &light;
+        if (!reactor.add(fd, EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET, connection.get()))
+        {
+            close(fd);
+            continue;
+        }
+        light.connections.push_back(connection.get());
+        connections.push_back(std::move(connection));
+        counters.connections++;
+    }
+}
+
+// Edge-triggered, so everything is read until the socket would block
+void FleetSimulator::readable(Connection & connection)
+{
+    char buffer[16384];
+    while (true)
+    {
+        ssize_t received = recv(connection.fd, buffer, sizeof(buffer), 0);
+        if (received > 0)
+        {
+            connection.in.append(buffer, static_cast<size_t>(received));
+            continue;
+        }
+        if (received < 0 && errno == EINTR)
+            continue;
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+
+        drop(connection);
+        return;
+    }
+
+    if (!connection.open && !handshake(connection))
+    {
+        drop(connection);
+        return;
+    }
+    if (connection.open && !frames(connection))
+        drop(connection);
+}
+
+void FleetSimulator::writable(Connection & connection)
+{
+    while (connection.out_pos < connection.out.size())
+    {
+        ssize_t written = ::send(connection.fd, connection.out.data() + connection.out_pos,
+                                 connection.out.size() - connection.out_pos, MSG_NOSIGNAL);
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return;
+        if (written <= 0)
+        {
+            drop(connection);
+            return;
+        }
+        connection.out_pos += static_cast<size_t>(written);
+        counters.bytes_sent += static_cast<uint64_t>(written);
+    }
+
+    connection.out.clear();
+    connection.out_pos = 0;
+}
+
+void FleetSimulator::drop(Connection & connection)
+{
+    if (connection.fd < 0)
+        return;
+
+    auto & others = connection.light->connections;
+    others.erase(std::remove(others.begin(), others.end(), &connection), others.end());
+
+    reactor.remove(connection.fd);
+    close(connection.fd);
+    connection.fd = -1;
+}
+
+// Returns false if the request isn't a websocket upgrade
+bool FleetSimulator::handshake(Connection & connection)
+{
+    size_t end = connection.in.find("\r\n\r\n");
+    if (end == std::string::npos)
+        return connection.in.size() < MAX_REQUEST_BYTES;
+
+    std::string_view key;
+    if (!find_header(std::string_view(connection.in).substr(0, end + 2), "Sec-WebSocket-Key", key))
+    {
+        ChipLogError(DeviceLayer, "[sim %zu] Request without Sec-WebSocket-Key", connection.light->index);
+        return false;
+    }
+
+    std::string response = "HTTP/1.1 101 Switching Protocols\r\n"
+                           "Upgrade: websocket\r\n"
+                           "Connection: Upgrade\r\n"
+                           "Sec-WebSocket-Accept: " +
+        compute_accept(key) + "\r\n\r\n";
+    connection.out += response;
+    connection.in.erase(0, end + 4);
+    connection.open = true;
+
+    // Like WLED, a new client gets the full state right away
+    render(*connection.light, document);
+    send_frame(connection, OPCODE_TEXT, document.data(), document.size());
+    counters.pushes++;
+    return connection.fd >= 0;
+}
+
+// Returns false if the connection should be dropped
+bool FleetSimulator::frames(Connection & connection)
+{
+    size_t pos = 0;
+    while (connection.fd >= 0)
+    {
+        const auto * frame = reinterpret_cast<const uint8_t *>(connection.in.data() + pos);
+        size_t available   = connection.in.size() - pos;
+        if (available < 2)
+            break;
+
+        bool fin       = frame[0] & FLAG_FIN;
+        uint8_t opcode = frame[0] & 0x0F;
+        bool masked    = frame[1] & FLAG_MASK;
+        size_t length  = frame[1] & 0x7F;
+        size_t header  = 2;
+
+        if (length == 126)
+        {
+            if (available < 4)
+                break;
+            length = static_cast<size_t>(frame[2]) << 8 | frame[3];
+            header = 4;
+        }
+        else if (length == 127)
+        {
+            if (available < 10)
+                break;
+            length = 0;
+            for (size_t i = 0; i < 8; i++)
+                length = length << 8 | frame[2 + i];
+            header = 10;
+        }
+        if (length > MAX_FRAME_BYTES)
+            return false;
+
+        const uint8_t * mask = frame + header;
+        if (masked)
+            header += 4;
+        if (available < header + length)
+            break;
+
+        std::string payload(reinterpret_cast<const char *>(frame + header), length);
+        if (masked)
+            for (size_t i = 0; i < length; i++)
+                payload[i] = static_cast<char>(payload[i] ^ mask[i % 4]);
+        pos += header + length;
+
+        switch (opcode)
+        {
+        case OPCODE_TEXT:
+        case OPCODE_CONTINUATION:
+            connection.message += payload;
+            if (connection.message.size() > MAX_FRAME_BYTES)
+                return false;
+            if (fin)
+            {
+                on_command(connection, connection.message);
+                connection.message.clear();
+            }
+            break;
+        case OPCODE_PING:
+            send_frame(connection, OPCODE_PONG, payload.data(), payload.size());
+            break;
+        case OPCODE_CLOSE:
+            send_frame(connection, OPCODE_CLOSE, payload.data(), std::min<size_t>(payload.size(), 2));
+            return false;
+        default:
+            break;
+        }
+    }
+
+    if (connection.fd >= 0)
+        connection.in.erase(0, pos);
+    return connection.fd >= 0;
+}
+
+// The light "receives" the command rtt from now and answers immediately, the whole round trip is folded into one delay
+void FleetSimulator::on_command(Connection & connection, const std::string & payload)
+{
+    // Commands are a bare state object, the parser wants a whole document
+    std::string wrapped = "{\"state\":" + payload + "}";
+    ParsedState command;
+    if (!StateParser::parse(wrapped, false, command))
+    {
+        ChipLogError(DeviceLayer, "[sim %zu] Could not parse %s", connection.light->index, payload.c_str());
+        return;
+    }
+
+    counters.commands++;
+    due.push({ Clock::now() + config.rtt, connection.light->index, false, command });
+}
+
+void FleetSimulator::send_frame(Connection & connection, uint8_t opcode, const char * data, size_t length)
+{
+    // Servers never mask
+    uint8_t header[10];
+    size_t header_length = 2;
+    header[0]            = static_cast<uint8_t>(FLAG_FIN | opcode);
+    if (length < 126)
+    {
+        header[1] = static_cast<uint8_t>(length);
+    }
+    else if (length <= 0xFFFF)
+    {
+        header[1]     = 126;
+        header[2]     = static_cast<uint8_t>(length >> 8);
+        header[3]     = static_cast<uint8_t>(length);
+        header_length = 4;
+    }
+    else
+    {
+        header[1] = 127;
+        for (size_t i = 0; i < 8; i++)
+            header[2 + i] = static_cast<uint8_t>(static_cast<uint64_t>(length) >> (56 - 8 * i));
+        header_length = 10;
+    }
+
+    connection.out.append(reinterpret_cast<const char *>(header), header_length);
+    connection.out.append(data, length);
+    writable(connection);
+}
+
+// WLED sends its whole state to every client after each change
+void FleetSimulator::push(Light & light)
+{
+    if (light.connections.empty())
+        return;
+
+    render(light, document);
+    // send_frame() may drop a connection, which takes it out of the list
+    auto clients = light.connections;
+    for (auto * connection : clients)
+        send_frame(*connection, OPCODE_TEXT, document.data(), document.size());
+    counters.pushes++;
+}
+
+void FleetSimulator::render(const Light & light, std::string & out) const
+{
+    bool white = config.capabilities & 0x2;
+    bool cct   = config.capabilities & 0x4;
+
+    out.clear();
+    out += "{\"state\":{\"on\":";
+    out += light.on ? "true" : "false";
+    out += ",\"bri\":";
+    append_number(out, light.brightness);
+    out += ",\"transition\":";
+    append_number(out, light.transition);
+    out += ",\"ps\":-1,\"pl\":-1,\"lor\":0,\"mainseg\":0,\"seg\":[{\"id\":0,\"start\":0,\"stop\":30,\"len\":30,\"on\":true,"
+           "\"bri\":255,\"cct\":";
+    append_number(out, light.cct);
+    out += ",\"col\":[[";
+    for (size_t i = 0; i < (white ? 4u : 3u); i++)
+    {
+        if (i)
+            out += ',';
+        append_number(out, light.color[i]);
+    }
+    out += "],[0,0,0],[0,0,0]],\"fx\":0,\"sx\":128,\"ix\":128,\"pal\":0,\"sel\":true}";
+    out += light.padding;
+    out += "]},\"info\":{\"ver\":\"0.14.0\",\"leds\":{\"count\":30,\"rgbw\":";
+    out += white ? "true" : "false";
+    out += ",\"cct\":";
+    out += cct ? "true" : "false";
+    out += ",\"lc\":";
+    append_number(out, static_cast<uint32_t>(config.capabilities));
+    out += "},\"name\":\"WLED Sim ";
+    append_number(out, static_cast<uint32_t>(light.index));
+    out += "\",\"arch\":\"esp32\",\"mac\":\"";
+    char mac[16];
+    snprintf(mac, sizeof(mac), "0200%08zx", light.index & 0xFFFFFFFF);
+    out += mac;
+    out += "\"}}";
+}
+
+void FleetSimulator::fire_due()
+{
+    auto now = Clock::now();
+    while (!due.empty() && due.top().when <= now)
+    {
+        Due item = due.top();
+        due.pop();
+        Light & light = *lights[item.light];
+
+        if (item.unsolicited)
+        {
+            auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1 / config.push_rate));
+            item.when += period;
+            // Don't try to catch up after falling behind, that would only be a burst of identical pushes
+            if (item.when < now)
+                item.when = now + period;
+            due.push(item);
+        }
+        else
+        {
+            const ParsedState & command = item.command;
+            if (command.has(ParsedState::kOn))
+                light.on = command.on;
+            if (command.has(ParsedState::kBrightness))
+                light.brightness = command.brightness;
+            if (command.has(ParsedState::kColor))
+                std::copy(command.color, command.color + command.color_count, light.color);
+            if (command.has(ParsedState::kCct))
+                light.cct = static_cast<uint8_t>(std::min<uint16_t>(command.cct, 255));
+        }
+
+        push(light);
+    }
+}
+
+void FleetSimulator::arm_timer()
+{
+    itimerspec spec = {};
+    if (!due.empty())
+    {
+        spec.it_value = to_timespec(due.top().when);
+        // All zeros would disarm it, a time in the past fires right away
+        if (spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0)
+            spec.it_value.tv_nsec = 1;
+    }
+    if (timerfd_settime(timer.fd, TFD_TIMER_ABSTIME, &spec, nullptr) < 0)
+        ChipLogError(DeviceLayer, "timerfd_settime: %s", strerror(errno));
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include "reactor.hpp"
+#include "state-parser.hpp"
+
+namespace wled {
+namespace bench {
+// Stand-in for a fleet of WLED lights on the loopback interface, one websocket server per light on consecutive ports.
+// Each light applies the commands it receives after `rtt` and pushes its whole state to every client, like WLED does,
+// and can also push on its own to mimic effects or other controllers. Everything runs on the thread calling run().
+class FleetSimulator
+{
+public:
+    struct Config
+    {
+        size_t devices     = 16;
+        uint16_t base_port = 19000;
+        // info.leds.lc: RGB (bit 0), white channel (bit 1), color temperature (bit 2)
+        int capabilities = 0x7;
+        // State pushes are padded with extra segments to about this size, real lights send 1-3KB
+        size_t payload_bytes = 1500;
+        // Command received -> state pushed back
+        std::chrono::microseconds rtt{ 2000 };
+        // Unsolicited pushes per light per second, 0 for none
+        double push_rate = 0;
+    };
+
+    struct Stats
+    {
+        uint64_t connections = 0;
+        uint64_t commands    = 0;
+        uint64_t pushes      = 0;
+        uint64_t bytes_sent  = 0;
+    };
+
+    explicit FleetSimulator(const Config & config);
+    ~FleetSimulator();
+
+    FleetSimulator(const FleetSimulator &)              = delete;
+    FleetSimulator & operator=(const FleetSimulator &)  = delete;
+    FleetSimulator(FleetSimulator && other)             = delete;
+    FleetSimulator & operator=(FleetSimulator && other) = delete;
+
+    // Binds every light's port on 127.0.0.1
+    bool listen();
+    // Serves until stop()
+    void run();
+    // Async-signal-safe
+    void stop();
+
+    const Stats & stats() const { return counters; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // Every descriptor in the reactor starts with one of these so events can be told apart
+    struct Handle
+    {
+        enum class Kind : uint8_t
+        {
+            kListener,
+            kConnection,
+            kTimer,
+        };
+
+        explicit Handle(Kind aKind) : kind(aKind) {}
+
+        Kind kind;
+        // -1 once closed, later events for it in the same batch are ignored
+        int fd = -1;
+    };
+
+    struct Connection;
+
+    // The handle is the listening socket
+    struct Light : Handle
+    {
+        Light() : Handle(Kind::kListener) {}
+
+        size_t index = 0;
+
+        bool on             = true;
+        uint8_t brightness  = 128;
+        uint8_t color[4]    = { 255, 160, 0, 0 };
+        uint8_t cct         = 127;
+        uint16_t transition = 7;
+
+        // Identical for every push, only the first segment changes
+        std::string padding;
+        std::vector<Connection *> connections;
+    };
+
+    struct Connection : Handle
+    {
+        Connection() : Handle(Kind::kConnection) {}
+
+        Light * light = nullptr;
+        bool open     = false;
+        std::string in;
+        std::string out;
+        size_t out_pos = 0;
+        // Payload of a fragmented message so far
+        std::string message;
+    };
+
+    // Something a light does later: apply a command and push, or push on its own
+    struct Due
+    {
+        Clock::time_point when;
+        size_t light;
+        bool unsolicited;
+        ParsedState command;
+
+        bool operator>(const Due & other) const { return when > other.when; }
+    };
+
+    void accept_all(Light & light);
+    void readable(Connection & connection);
+    void writable(Connection & connection);
+    void drop(Connection & connection);
+
+    bool handshake(Connection & connection);
+    bool frames(Connection & connection);
+    void on_command(Connection & connection, const std::string & payload);
+
+    void send_frame(Connection & connection, uint8_t opcode, const char * data, size_t length);
+    void push(Light & light);
+    void render(const Light & light, std::string & out) const;
+
+    void fire_due();
+    void arm_timer();
+
+    Config config;
+    Reactor reactor;
+    Handle timer{ Handle::Kind::kTimer };
+    std::vector<std::unique_ptr<Light>> lights;
+    std::vector<std::unique_ptr<Connection>> connections;
+    std::priority_queue<Due, std::vector<Due>, std::greater<Due>> due;
+    std::string document;
+    std::atomic<bool> stopping{ false };
+    Stats counters;
+};
+} // namespace bench
+} // namespace wled
@@ -0,0 +1,414 @@
+#include <cinttypes>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <getopt.h>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <thread>
+#include <vector>
+
+#include <lib/support/CHIPMem.h>
+
+#include "fleet-simulator.hpp"
+#include "monitor.hpp"
+#include "wled.h"
+
+// The same globals main.cpp defines for the bridge, driven by a wled::Monitor on its own thread
+int wled_monitor_pipe[2];
+wled::Reactor gReactor;
+wled::TimerWheel gTimerWheel;
+wled::Coalescer gCoalescer(gTimerWheel, gReactor);
+wled::ReconnectManager gReconnects(gTimerWheel, gReactor);
+wled::MetricsRegistry gMetrics;
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+struct Options
+{
+    wled::bench::FleetSimulator::Config fleet;
+    // Writes per second across the whole fleet
+    double rate = 200;
+    std::chrono::seconds duration{ 10 };
+    wled::Coalescer::Config coalesce;
+    bool sim_only = false;
+};
+
+// Same budget as the bridge's default WLED_KEEPALIVE_MS
+constexpr std::chrono::milliseconds kKeepaliveBudget{ 15000 };
+
+constexpr const char * kStageNames[] = { "coalesce", "send", "device", "total" };
+static_assert(std::size(kStageNames) == static_cast<size_t>(wled::CommandStage::kCount), "Every command stage needs a name");
+
+wled::bench::FleetSimulator * gSimulator = nullptr;
+
+void usage(const char * program)
+{
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  --devices N        lights to simulate (16)\n"
+            "  --rate N           writes per second across all lights (200)\n"
+            "  --duration S       seconds of load (10)\n"
+            "  --rtt MS           delay between a light receiving a command and pushing its state (2)\n"
+            "  --push-rate N      unsolicited state pushes per light per second (0)\n"
+            "  --payload BYTES    size of a state push, the bridge drops anything over 24576 (1500)\n"
+            "  --lc N             info.leds.lc: 1 RGB, 2 white channel, 4 color temperature (7)\n"
+            "  --port N           first light's port, the others follow (19000)\n"
+            "  --coalesce-ms MS   coalescing window, same as WLED_COALESCE_MS (50)\n"
+            "  --sim-only         only serve the lights, e.g. to add them to a running bridge\n",
+            program);
+}
+
+bool parse_options(int argc, char ** argv, Options & options)
+{
+    enum
+    {
+        kDevices = 1,
+        kRate,
+        kDuration,
+        kRtt,
+        kPushRate,
+        kPayload,
+        kCapabilities,
+        kPort,
+        kCoalesce,
+        kSimOnly,
+        kHelp,
+    };
+    static const option long_options[] = {
+        { "devices", required_argument, nullptr, kDevices },
+        { "rate", required_argument, nullptr, kRate },
+        { "duration", required_argument, nullptr, kDuration },
+        { "rtt", required_argument, nullptr, kRtt },
+        { "push-rate", required_argument, nullptr, kPushRate },
+        { "payload", required_argument, nullptr, kPayload },
+        { "lc", required_argument, nullptr, kCapabilities },
+        { "port", required_argument, nullptr, kPort },
+        { "coalesce-ms", required_argument, nullptr, kCoalesce },
+        { "sim-only", no_argument, nullptr, kSimOnly },
+        { "help", no_argument, nullptr, kHelp },
+        { nullptr, 0, nullptr, 0 },
+    };
+
+    int option;
+    while ((option = getopt_long(argc, argv, "", long_options, nullptr)) != -1)
+    {
+        switch (option)
+        {
+        case kDevices:
+            options.fleet.devices = std::stoul(optarg);
+            break;
+        case kRate:
+            options.rate = std::stod(optarg);
+            break;
+        case kDuration:
+            options.duration = std::chrono::seconds(std::stoi(optarg));
+            break;
+        case kRtt:
+            options.fleet.rtt = std::chrono::microseconds(static_cast<int64_t>(std::stod(optarg) * 1000));
+            break;
+        case kPushRate:
+            options.fleet.push_rate = std::stod(optarg);
+            break;
+        case kPayload:
+            options.fleet.payload_bytes = std::stoul(optarg);
+            break;
+        case kCapabilities:
+            options.fleet.capabilities = std::stoi(optarg, nullptr, 0);
+            break;
+        case kPort:
+            options.fleet.base_port = static_cast<uint16_t>(std::stoi(optarg));
+            break;
+        case kCoalesce:
+            options.coalesce.window = std::chrono::milliseconds(std::stoi(optarg));
+            break;
+        case kSimOnly:
+            options.sim_only = true;
+            break;
+        case kHelp:
+            usage(argv[0]);
+            exit(0);
+        default:
+            return false;
+        }
+    }
+
+    if (options.fleet.devices == 0 || options.rate <= 0 || options.duration.count() <= 0 ||
+        options.fleet.base_port + options.fleet.devices > 65536)
+        return false;
+    return optind == argc;
+}
+
+void on_terminate(int)
+{
+    if (gSimulator)
+        gSimulator->stop();
+}
+
+// Serves until SIGTERM/SIGINT. `ready_fd`, if any, is written to once every port is bound.
+int run_simulator(const wled::bench::FleetSimulator::Config & config, int ready_fd)
+{
+    wled::bench::FleetSimulator simulator(config);
+    if (!simulator.listen())
+        return 1;
+
+    gSimulator = &simulator;
+    signal(SIGTERM, on_terminate);
+    signal(SIGINT, on_terminate);
+
+    if (ready_fd >= 0)
+    {
+        char ready = 1;
+        if (write(ready_fd, &ready, 1) < 1)
+            return 1;
+        close(ready_fd);
+    }
+    else
+    {
+        printf("Serving %zu lights on 127.0.0.1:%u-%zu\n", config.devices, config.base_port,
+               config.base_port + config.devices - 1);
+        fflush(stdout);
+    }
+
+    simulator.run();
+
+    const auto & stats = simulator.stats();
+    printf("simulator: %" PRIu64 " connections, %" PRIu64 " commands, %" PRIu64 " pushes, %.1f MB sent\n", stats.connections,
+           stats.commands, stats.pushes, static_cast<double>(stats.bytes_sent) / 1e6);
+    fflush(stdout);
+    return 0;
+}
+
+enum class Write : uint8_t
+{
+    kLevel,
+    kColor,
+    kMireds,
+};
+
+// Round-robins writes over the lights at a fixed rate, cycling through whatever the lights support. Every write is
+// stamped like a Matter write so the stage histograms cover exactly what they cover in the bridge.
+uint64_t generate_load(const std::vector<std::unique_ptr<WLED>> & lights, const Options & options)
+{
+    std::vector<Write> writes = { Write::kLevel };
+    if (options.fleet.capabilities & 0x1)
+        writes.push_back(Write::kColor);
+    if (options.fleet.capabilities & 0x4)
+        writes.push_back(Write::kMireds);
+
+    std::mt19937 random(42);
+    std::uniform_int_distribution<int> level(1, 254);
+    std::uniform_int_distribution<int> hue(0, 254);
+    std::uniform_int_distribution<int> saturation(0, 254);
+    std::uniform_int_distribution<int> mireds(153, 500);
+
+    auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1 / options.rate));
+    auto next   = Clock::now();
+    auto end    = next + options.duration;
+
+    uint64_t issued = 0;
+    for (size_t n = 0; next < end; n++, next += period)
+    {
+        std::this_thread::sleep_until(next);
+
+        WLED & light = *lights[n % lights.size()];
+        if (!light.IsReachable())
+            continue;
+
+        wled::ReceivedScope received(Clock::now());
+        switch (writes[(n / lights.size()) % writes.size()])
+        {
+        case Write::kLevel:
+            light.SetLevel(static_cast<uint8_t>(level(random)));
+            break;
+        case Write::kColor:
+            light.SetHue(static_cast<uint8_t>(hue(random)));
+            light.SetSaturation(static_cast<uint8_t>(saturation(random)));
+            break;
+        case Write::kMireds:
+            light.SetMireds(static_cast<uint16_t>(mireds(random)));
+            break;
+        }
+        issued++;
+    }
+    return issued;
+}
+
+double seconds(const timeval & time)
+{
+    return static_cast<double>(time.tv_sec) + static_cast<double>(time.tv_usec) / 1e6;
+}
+
+double cpu_seconds(const rusage & usage)
+{
+    return seconds(usage.ru_utime) + seconds(usage.ru_stime);
+}
+
+void print_count(const char * name, uint64_t count, double elapsed)
+{
+    printf("  %-12s %10" PRIu64 " %10.1f/s\n", name, count, static_cast<double>(count) / elapsed);
+}
+
+void print_histogram(const char * name, const wled::Histogram & histogram)
+{
+    uint64_t count = histogram.count();
+    double mean    = count ? static_cast<double>(histogram.sum()) / static_cast<double>(count) / 1000 : 0;
+    printf("  %-12s %10" PRIu64 " %10.3f %10.3f %10.3f\n", name, count, mean,
+           static_cast<double>(histogram.percentile(0.5)) / 1000, static_cast<double>(histogram.percentile(0.99)) / 1000);
+}
+
+void report(const std::vector<std::unique_ptr<WLED>> & lights, const Options & options, uint64_t issued, double elapsed,
+            double cpu)
+{
+    constexpr size_t kStages = static_cast<size_t>(wled::CommandStage::kCount);
+    wled::Histogram stages[kStages];
+    wled::Histogram send_latency;
+    wled::Histogram parse_time;
+    uint64_t submitted = 0, sent = 0, unconfirmed = 0, reconnects = 0;
+
+    for (const auto & light : lights)
+    {
+        const auto & metrics = light->Metrics();
+        for (size_t i = 0; i < kStages; i++)
+            stages[i].merge(metrics.stages[i]);
+        send_latency.merge(metrics.send_latency);
+        parse_time.merge(metrics.parse_time);
+        submitted += metrics.commands_submitted.value();
+        sent += metrics.commands_sent.value();
+        unconfirmed += metrics.commands_unconfirmed.value();
+        reconnects += metrics.reconnect_attempts.value();
+    }
+
+    uint64_t confirmed = stages[static_cast<size_t>(wled::CommandStage::kDevice)].count();
+    double load        = static_cast<double>(options.duration.count());
+
+    printf("\n%zu lights, lc %d, %zu byte pushes, %.3f ms rtt, %.1f pushes/s per light, %.0f writes/s for %.0f s\n",
+           lights.size(), options.fleet.capabilities, options.fleet.payload_bytes,
+           static_cast<double>(options.fleet.rtt.count()) / 1000, options.fleet.push_rate, options.rate, load);
+    print_count("writes", issued, load);
+    print_count("submitted", submitted, load);
+    print_count("sent", sent, load);
+    print_count("confirmed", confirmed, load);
+    print_count("unconfirmed", unconfirmed, load);
+    print_count("reconnects", reconnects, load);
+
+    printf("\n  %-12s %10s %10s %10s %10s  (ms)\n", "", "count", "mean", "p50", "p99");
+    for (size_t i = 0; i < kStages; i++)
+        print_histogram(kStageNames[i], stages[i]);
+    print_histogram("socket", send_latency);
+    print_histogram("parse", parse_time);
+
+    double per_light = cpu / static_cast<double>(lights.size());
+    printf("\n  %-12s %10.3f s, %.3f%% of a core per light, %.1f us per sent command\n", "cpu", cpu,
+           100 * per_light / elapsed, sent ? cpu * 1e6 / static_cast<double>(sent) : 0.0);
+}
+} // namespace
+
+int main(int argc, char ** argv)
+{
+    Options options;
+    if (!parse_options(argc, argv, options))
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    if (options.sim_only)
+        return run_simulator(options.fleet, -1);
+
+    // The lights run in their own process so their CPU isn't counted against the bridge side
+    int ready[2];
+    if (pipe(ready) < 0)
+    {
+        perror("pipe");
+        return 1;
+    }
+    pid_t simulator = fork();
+    if (simulator < 0)
+    {
+        perror("fork");
+        return 1;
+    }
+    if (simulator == 0)
+    {
+        close(ready[0]);
+        _exit(run_simulator(options.fleet, ready[1]));
+    }
+    close(ready[1]);
+
+    char byte;
+    if (read(ready[0], &byte, 1) < 1)
+    {
+        fprintf(stderr, "Simulator did not start\n");
+        waitpid(simulator, nullptr, 0);
+        return 1;
+    }
+    close(ready[0]);
+
+    if (chip::Platform::MemoryInit() != CHIP_NO_ERROR || pipe(wled_monitor_pipe) < 0)
+    {
+        fprintf(stderr, "Could not initialize\n");
+        kill(simulator, SIGTERM);
+        waitpid(simulator, nullptr, 0);
+        return 1;
+    }
+    gCoalescer.configure(options.coalesce);
+
+    std::vector<std::unique_ptr<WLED>> lights;
+    for (size_t i = 0; i < options.fleet.devices; i++)
+    {
+        std::string address = "127.0.0.1:" + std::to_string(options.fleet.base_port + i);
+        lights.push_back(std::make_unique<WLED>(address, "Bench", false));
+    }
+
+    {
+        std::vector<std::thread> starting;
+        for (auto & light : lights)
+            starting.emplace_back([&light] { light->Start(); });
+        for (auto & thread : starting)
+            thread.join();
+    }
+
+    size_t reachable = 0;
+    for (const auto & light : lights)
+        reachable += light->IsReachable();
+    if (reachable < lights.size())
+        fprintf(stderr, "Only %zu of %zu lights connected\n", reachable, lights.size());
+
+    auto fleet = [&lights](std::vector<WLED *> & out) {
+        for (const auto & light : lights)
+            out.push_back(light.get());
+    };
+    wled::Monitor monitor(gReactor, gTimerWheel, wled_monitor_pipe[0], fleet, kKeepaliveBudget);
+    std::thread monitoring(&wled::Monitor::run, &monitor);
+
+    rusage before, after;
+    getrusage(RUSAGE_SELF, &before);
+    auto start = Clock::now();
+
+    uint64_t issued = reachable ? generate_load(lights, options) : 0;
+    // Long enough for the last coalesced writes to go out and be confirmed
+    std::this_thread::sleep_for(options.coalesce.max_delay + options.fleet.rtt + std::chrono::milliseconds(500));
+
+    getrusage(RUSAGE_SELF, &after);
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+    monitor.stop();
+    monitoring.join();
+
+    report(lights, options, issued, elapsed, cpu_seconds(after) - cpu_seconds(before));
+    lights.clear();
+
+    fflush(stdout);
+    kill(simulator, SIGTERM);
+    rusage simulator_usage;
+    int status;
+    if (wait4(simulator, &status, 0, &simulator_usage) == simulator)
+        printf("  %-12s %10.3f s cpu\n", "simulator", cpu_seconds(simulator_usage));
+
+    return reachable ? 0 : 1;
+}
@@ -0,0 +1,87 @@
+#include <algorithm>
+
+#include "coalescer.hpp"
+
+using namespace wled;
+
+Coalescer::Target::Target() : timer(on_timer, this) {}
+
+Coalescer::Target::~Target()
+{
+    if (owner)
+        owner->cancel(*this);
+}
+
+void Coalescer::Target::on_timer(void * context)
+{
+    auto target = static_cast<Target *>(context);
+    target->owner->expire(*target);
+}
+
+void Coalescer::configure(const Config & aConfig)
+{
+    std::lock_guard lock(mutex);
+    config = aConfig;
+    if (config.max_delay < config.window)
+        config.max_delay = config.window;
+    if (config.settle > config.window)
+        config.settle = config.window;
+}
+
+void Coalescer::submit(Target & target, bool leading)
+{
+    auto now = Clock::now();
+    {
+        std::lock_guard lock(mutex);
+        target.owner = this;
+
+        if (!target.pending)
+        {
+            bool idle = now - target.last_flush >= config.window;
+            // Nothing went out recently, don't make the first command of a burst wait
+            if (idle && leading)
+                target.last_flush = now;
+            else
+            {
+                target.pending        = true;
+                target.settling       = idle;
+                target.first_deferred = now;
+            }
+        }
+
+        if (target.pending)
+        {
+            // Trailing edge: wait for the writes to go quiet, bounded by the max delay. A set that skipped the leading
+            // edge only waits for its other halves.
+            auto limit    = target.settling ? config.settle : config.max_delay;
+            auto deadline = std::min(now + config.window, target.first_deferred + limit);
+            if (timers.schedule(target.timer, deadline))
+                reactor.wake();
+            return;
+        }
+    }
+
+    target.flush();
+}
+
+void Coalescer::cancel(Target & target)
+{
+    // Not under the mutex, a flush that is already running takes it in expire() and cancel() waits for that
+    timers.cancel(target.timer);
+
+    std::lock_guard lock(mutex);
+    target.pending = false;
+}
+
+void Coalescer::expire(Target & target)
+{
+    {
+        std::lock_guard lock(mutex);
+        // Cancelled, or flushed some other way, after the timer already fired
+        if (!target.pending)
+            return;
+        target.pending    = false;
+        target.last_flush = Clock::now();
+    }
+    target.flush();
+}
@@ -0,0 +1,35 @@
+#include "color-accumulator.hpp"
+#include "color-utils.h"
+
+using namespace wled;
+
+void ColorAccumulator::set(Component component, uint8_t value)
+{
+    switch (component)
+    {
+    case kHue:
+        values.hue = value;
+        break;
+    case kSaturation:
+        values.saturation = value;
+        break;
+    }
+    staged |= component;
+}
+
+void ColorAccumulator::resolve(const ColorComponents & current, bool with_white, Command & command)
+{
+    HsvColor hsv;
+    hsv.h  = (staged & kHue) ? values.hue : current.hue;
+    hsv.s  = (staged & kSaturation) ? values.saturation : current.saturation;
+    hsv.v  = current.value;
+    staged = 0;
+
+    RgbColor rgb = HsvToRgb(hsv);
+    command.fields |= Command::kColor;
+    command.color[0]    = rgb.r;
+    command.color[1]    = rgb.g;
+    command.color[2]    = rgb.b;
+    command.color[3]    = current.white;
+    command.color_count = with_white ? 4 : 3;
+}
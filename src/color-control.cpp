@@ -0,0 +1,102 @@
+#include "color-control.hpp"
+
+#include <app-common/zap-generated/cluster-objects.h>
+#include <app/data-model/Decode.h>
+#include <lib/core/TLVReader.h>
+
+#include "wled.h"
+
+using namespace wled;
+using namespace chip::app::Clusters::ColorControl;
+
+ColorControlHandler::ColorControlHandler(Lookup lookup) :
+    CommandHandlerInterface(chip::NullOptional, chip::app::Clusters::ColorControl::Id), lookup(lookup)
+{}
+
+void ColorControlHandler::InvokeCommand(HandlerContext & ctx)
+{
+    switch (ctx.mRequestPath.mCommandId)
+    {
+    case Commands::MoveToHue::Id: {
+        Commands::MoveToHue::DecodableType request;
+        if (!decode(ctx, request))
+            return;
+        if (WLED * light = light_for(ctx, request.transitionTime))
+        {
+            light->MoveToHue(request.hue, static_cast<WLED::HueDirection>(request.direction), request.transitionTime);
+            handled(ctx);
+        }
+        break;
+    }
+    case Commands::MoveToSaturation::Id: {
+        Commands::MoveToSaturation::DecodableType request;
+        if (!decode(ctx, request))
+            return;
+        if (WLED * light = light_for(ctx, request.transitionTime))
+        {
+            light->MoveToSaturation(request.saturation, request.transitionTime);
+            handled(ctx);
+        }
+        break;
+    }
+    case Commands::MoveToHueAndSaturation::Id: {
+        Commands::MoveToHueAndSaturation::DecodableType request;
+        if (!decode(ctx, request))
+            return;
+        if (WLED * light = light_for(ctx, request.transitionTime))
+        {
+            light->MoveToHueAndSaturation(request.hue, request.saturation, request.transitionTime);
+            handled(ctx);
+        }
+        break;
+    }
+    case Commands::MoveToColorTemperature::Id: {
+        Commands::MoveToColorTemperature::DecodableType request;
+        if (!decode(ctx, request))
+            return;
+        if (WLED * light = light_for(ctx, request.transitionTime))
+        {
+            light->MoveToMireds(request.colorTemperatureMireds, request.transitionTime);
+            handled(ctx);
+        }
+        break;
+    }
+    case Commands::StopMoveStep::Id: {
+        // Only transitions this handler started, the server stops its own
+        WLED * light = lookup(ctx.mRequestPath.mEndpointId);
+        if (light != nullptr && light->StopColorTransitions())
+            handled(ctx);
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+WLED * ColorControlHandler::light_for(HandlerContext & ctx, uint16_t transition_time)
+{
+    if (transition_time == 0)
+        return nullptr;
+
+    // A light that is off only changes color if its options say so, the server decides that
+    WLED * light = lookup(ctx.mRequestPath.mEndpointId);
+    if (light == nullptr || !light->IsReachable() || !light->IsOn())
+        return nullptr;
+
+    ChipLogProgress(DeviceLayer, "[%s] Color transition over %dms", light->GetName(), transition_time * 100);
+    return light;
+}
+
+template <typename Request>
+bool ColorControlHandler::decode(HandlerContext & ctx, Request & request)
+{
+    // Decode a copy, the server reads the payload again if the command is left to it
+    chip::TLV::TLVReader reader(ctx.mPayload);
+    return chip::app::DataModel::Decode(reader, request) == CHIP_NO_ERROR;
+}
+
+void ColorControlHandler::handled(HandlerContext & ctx)
+{
+    ctx.mCommandHandler.AddStatus(ctx.mRequestPath, chip::Protocols::InteractionModel::Status::Success);
+    ctx.SetCommandHandled();
+}
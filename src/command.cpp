@@ -0,0 +1,170 @@
+#include "command.hpp"
+
+using namespace wled;
+
+void Command::merge(const Command & newer)
+{
+    if (newer.has(kOn))
+        on = newer.on;
+    if (newer.has(kBrightness))
+        brightness = newer.brightness;
+    if (newer.has(kColor))
+    {
+        for (size_t i = 0; i < 4; i++)
+            color[i] = newer.color[i];
+        color_count = newer.color_count;
+    }
+    if (newer.has(kCct))
+        cct = newer.cct;
+    if (newer.has(kTransition))
+        transition = newer.transition;
+    else if ((fields & ~newer.fields & ~kTransition) == 0)
+    {
+        // Nothing is left that the older transition applied to
+        fields &= static_cast<uint8_t>(~kTransition);
+        transition = 0;
+    }
+    fields |= newer.fields;
+
+    // The merged command is as old as the oldest write in it
+    if (received == std::chrono::steady_clock::time_point{} ||
+        (newer.received != std::chrono::steady_clock::time_point{} && newer.received < received))
+        received = newer.received;
+}
+
+bool Command::conflicts(const Command & newer) const
+{
+    if (has(kTransition) == newer.has(kTransition) && (!has(kTransition) || transition == newer.transition))
+        return false;
+    // Fields the newer command replaces go out with its transition either way
+    return (fields & ~newer.fields & ~kTransition) != 0;
+}
+
+Expectation Command::expectation() const
+{
+    Expectation expectation;
+
+    if (has(kOn))
+    {
+        expectation.fields |= Expectation::kOn;
+        expectation.on = on;
+    }
+    if (has(kBrightness))
+    {
+        expectation.fields |= Expectation::kBrightness;
+        expectation.brightness = brightness;
+    }
+    if (has(kColor))
+    {
+        expectation.fields |= Expectation::kColor;
+        for (size_t i = 0; i < 3; i++)
+            expectation.color[i] = color[i];
+    }
+    if (has(kCct))
+    {
+        expectation.fields |= Expectation::kCct;
+        expectation.cct = cct;
+    }
+
+    expectation.received = received;
+    expectation.flushed  = flushed;
+    return expectation;
+}
+
+namespace {
+thread_local std::chrono::steady_clock::time_point tReceived;
+} // namespace
+
+ReceivedScope::ReceivedScope(std::chrono::steady_clock::time_point received) : previous(tReceived)
+{
+    tReceived = received;
+}
+
+ReceivedScope::~ReceivedScope()
+{
+    tReceived = previous;
+}
+
+std::chrono::steady_clock::time_point ReceivedScope::current()
+{
+    if (tReceived == std::chrono::steady_clock::time_point{})
+        return std::chrono::steady_clock::now();
+    return tReceived;
+}
+
+size_t CommandEncoder::encode(const Command & command, Buffer & buffer)
+{
+    CommandEncoder encoder(buffer);
+
+    encoder.character('{');
+    if (command.has(Command::kOn))
+    {
+        encoder.separator();
+        encoder.literal(command_json::kOn);
+        if (command.on)
+            encoder.literal(command_json::kTrue);
+        else
+            encoder.literal(command_json::kFalse);
+    }
+    if (command.has(Command::kBrightness))
+    {
+        encoder.separator();
+        encoder.literal(command_json::kBrightness);
+        encoder.number(command.brightness);
+    }
+    if (command.has(Command::kTransition))
+    {
+        encoder.separator();
+        encoder.literal(command_json::kTransition);
+        encoder.number(command.transition);
+    }
+    if (command.has(Command::kColor) || command.has(Command::kCct))
+    {
+        encoder.separator();
+        encoder.literal(command_json::kSegment);
+        encoder.first = true;
+        if (command.has(Command::kColor))
+        {
+            encoder.separator();
+            encoder.literal(command_json::kColor);
+            for (size_t i = 0; i < command.color_count && i < 4; i++)
+            {
+                if (i)
+                    encoder.character(',');
+                encoder.number(command.color[i]);
+            }
+            encoder.literal(command_json::kColorEnd);
+        }
+        if (command.has(Command::kCct))
+        {
+            encoder.separator();
+            encoder.literal(command_json::kCct);
+            encoder.number(command.cct);
+        }
+        encoder.character('}');
+    }
+    encoder.character('}');
+
+    return static_cast<size_t>(encoder.cur - buffer);
+}
+
+void CommandEncoder::number(uint32_t value)
+{
+    char digits[10];
+    size_t count = 0;
+    do
+    {
+        digits[count++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value);
+
+    while (count)
+        *cur++ = digits[--count];
+}
+
+void CommandEncoder::separator()
+{
+    if (!first)
+        *cur++ = ',';
+    first = false;
+}
@@ -19,8 +19,11 @@
 
 #pragma once
 
-#include <app/util/attribute-storage.h>
+#include <app-common/zap-generated/cluster-enums.h>
+#include <lib/core/DataModelTypes.h>
+#include <lib/support/CHIPMemString.h>
 
+#include <atomic>
 #include <chrono>
 #include <functional>
 #include <stdbool.h>
@@ -64,6 +67,11 @@ public:
     inline std::string GetZone() { return mZone; };
     inline void SetZone(std::string zone) { mZone = zone; };
 
+    // Attributes that changed since the last report pass, one bit per attribute. Set from any thread, taken on the
+    // CHIP thread.
+    inline uint32_t MarkDirty(uint32_t bits) { return mDirty.fetch_or(bits); };
+    inline uint32_t TakeDirty() { return mDirty.exchange(0); };
+
     virtual inline std::string GetManufacturer() = 0;
     virtual inline std::string GetSerialNumber() = 0;
     virtual inline std::string GetModel()        = 0;
@@ -78,6 +86,7 @@ protected:
     chip::EndpointId mEndpointId       = 0;
     chip::EndpointId mParentEndpointId = 0;
     std::string mZone                  = "";
+    std::atomic<uint32_t> mDirty{ 0 };
 };
 
 class DeviceOnOff : public Device
@@ -129,6 +138,8 @@ public:
 
     virtual uint8_t Level();
     virtual void SetLevel(uint8_t aLevel);
+    // Tenths of a second left in a level transition
+    virtual uint16_t LevelRemainingTime() { return 0; }
 
     using DeviceCallback_fn = std::function<void(DeviceDimmable *, DeviceDimmable::Changed_t)>;
     void SetChangeCallback(DeviceCallback_fn aChanged_CB);
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <chrono>
+#include <mutex>
+
+#include "reactor.hpp"
+#include "timer-wheel.hpp"
+
+namespace wled {
+// Decides when a device's pending command delta goes out. A device that has been quiet for a whole window is flushed
+// immediately (leading edge), anything arriving after that is merged by the device and flushed once the stream goes
+// quiet for `window`, but never later than `max_delay` after the first deferred write. All deferred flushes run on the
+// monitor loop through the shared timer wheel, so a burst costs no threads.
+//
+// Deltas that usually arrive as a set (hue then saturation) can skip the leading edge, a quiet device then only waits
+// `settle` for the rest of the set instead of sending the first half on its own.
+class Coalescer
+{
+public:
+    using Clock = TimerWheel::Clock;
+
+    struct Config
+    {
+        std::chrono::milliseconds window{ 50 };
+        std::chrono::milliseconds max_delay{ 200 };
+        // One timer wheel tick
+        std::chrono::milliseconds settle{ 5 };
+    };
+
+    class Target
+    {
+    public:
+        Target();
+        virtual ~Target();
+
+        // Sends whatever delta has been accumulated, called without any coalescer lock held
+        virtual void flush() = 0;
+
+    private:
+        friend class Coalescer;
+        static void on_timer(void * context);
+
+        Coalescer * owner = nullptr;
+        TimerWheel::Timer timer;
+        bool pending  = false;
+        bool settling = false;
+        Clock::time_point first_deferred;
+        Clock::time_point last_flush;
+    };
+
+    Coalescer(TimerWheel & timers, Reactor & reactor) : timers(timers), reactor(reactor) {}
+
+    Coalescer(const Coalescer &)              = delete;
+    Coalescer & operator=(const Coalescer &)  = delete;
+    Coalescer(Coalescer && other)             = delete;
+    Coalescer & operator=(Coalescer && other) = delete;
+
+    void configure(const Config & config);
+    // Call after merging a new delta into the target, `leading` = false never flushes on the spot
+    void submit(Target & target, bool leading = true);
+    void cancel(Target & target);
+
+private:
+    void expire(Target & target);
+
+    TimerWheel & timers;
+    Reactor & reactor;
+    Config config;
+    std::mutex mutex;
+};
+} // namespace wled
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "command.hpp"
+
+namespace wled {
+// What the light is showing, as Matter sees it
+struct ColorComponents
+{
+    uint8_t hue        = 0;
+    uint8_t saturation = 0;
+    uint8_t value      = 0;
+    uint8_t white      = 0;
+};
+
+// Matter changes a color one attribute at a time. Hue and saturation are only recorded as they arrive and turned into
+// RGB(W) once per flush, together with whatever brightness and white the light has by then, so a hue and saturation
+// pair goes out as a single, final color instead of two.
+class ColorAccumulator
+{
+public:
+    enum Component : uint8_t
+    {
+        kHue        = 1u << 0,
+        kSaturation = 1u << 1,
+    };
+
+    void set(Component component, uint8_t value);
+
+    // Something changed since the last resolve()
+    bool dirty() const { return staged != 0; }
+
+    // Writes the RGB(W) for everything staged, anything not staged comes from `current`
+    void resolve(const ColorComponents & current, bool with_white, Command & command);
+
+    void clear() { staged = 0; }
+
+private:
+    ColorComponents values;
+    uint8_t staged = 0;
+};
+} // namespace wled
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <app/CommandHandlerInterface.h>
+
+class WLED;
+
+namespace wled {
+// Takes MoveToHue, MoveToSaturation, MoveToHueAndSaturation and MoveToColorTemperature with a transition time away
+// from the ColorControl server, which would step the attributes locally and write a full color to the light on every
+// step. WLED fades natively from one command instead. Moves, steps and instant changes are left to the server.
+class ColorControlHandler : public chip::app::CommandHandlerInterface
+{
+public:
+    using Lookup = WLED * (*) (chip::EndpointId);
+
+    explicit ColorControlHandler(Lookup lookup);
+    ~ColorControlHandler() = default;
+
+    ColorControlHandler(const ColorControlHandler &)              = delete;
+    ColorControlHandler & operator=(const ColorControlHandler &)  = delete;
+    ColorControlHandler(ColorControlHandler && other)             = delete;
+    ColorControlHandler & operator=(ColorControlHandler && other) = delete;
+
+    void InvokeCommand(HandlerContext & ctx) override;
+
+private:
+    // The light to hand `ctx` to, or nullptr if the server should handle it
+    WLED * light_for(HandlerContext & ctx, uint16_t transition_time);
+
+    template <typename Request>
+    bool decode(HandlerContext & ctx, Request & request);
+
+    void handled(HandlerContext & ctx);
+
+    Lookup lookup;
+};
+} // namespace wled
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <chrono>
+
+#include "inflight.hpp"
+
+namespace wled {
+// One coalesced write to a light. Merging keeps the newest value of every field. WLED applies a single `tt` to the whole
+// request, so commands only merge cleanly if they agree on the transition or the newer one replaces every field.
+struct Command
+{
+    enum Field : uint8_t
+    {
+        kOn         = 1u << 0,
+        kBrightness = 1u << 1,
+        kColor      = 1u << 2,
+        kCct        = 1u << 3,
+        kTransition = 1u << 4,
+    };
+
+    uint8_t fields     = 0;
+    bool on            = false;
+    uint8_t brightness = 0;
+    // Primary color, r/g/b/w. `color_count` is 4 for lights with a white channel.
+    uint8_t color[4]    = {};
+    uint8_t color_count = 3;
+    uint8_t cct         = 0;
+    // In 100ms units
+    uint16_t transition = 0;
+
+    // When the oldest write merged into this command arrived and when the coalescer let it go, for latency tracing
+    std::chrono::steady_clock::time_point received;
+    std::chrono::steady_clock::time_point flushed;
+
+    bool empty() const { return fields == 0; }
+    bool has(Field field) const { return (fields & field) != 0; }
+
+    void merge(const Command & newer);
+    // Merging `newer` would move some of this command's fields to the other command's transition, e.g. a plain SetHue
+    // picking up a level fade. This command has to go out on its own first then.
+    bool conflicts(const Command & newer) const;
+    Expectation expectation() const;
+};
+
+// While alive, commands staged on this thread are timed from `received`, the arrival of the Matter write that caused
+// them, instead of from when they reach the light's pipeline. Scopes nest.
+class ReceivedScope
+{
+public:
+    explicit ReceivedScope(std::chrono::steady_clock::time_point received);
+    ~ReceivedScope();
+
+    ReceivedScope(const ReceivedScope &)              = delete;
+    ReceivedScope & operator=(const ReceivedScope &)  = delete;
+    ReceivedScope(ReceivedScope && other)             = delete;
+    ReceivedScope & operator=(ReceivedScope && other) = delete;
+
+    // The innermost scope's time, or now outside of any
+    static std::chrono::steady_clock::time_point current();
+
+private:
+    std::chrono::steady_clock::time_point previous;
+};
+
+// Fragments of the JSON the encoder writes, kept here so the worst case size is known at compile time
+namespace command_json {
+inline constexpr char kOn[]         = "\"on\":";
+inline constexpr char kTrue[]       = "true";
+inline constexpr char kFalse[]      = "false";
+inline constexpr char kBrightness[] = "\"bri\":";
+inline constexpr char kTransition[] = "\"tt\":";
+inline constexpr char kSegment[]    = "\"seg\":{";
+inline constexpr char kColor[]      = "\"col\":[[";
+inline constexpr char kColorEnd[]   = "]]";
+inline constexpr char kCct[]        = "\"cct\":";
+
+template <size_t N>
+constexpr size_t length(const char (&)[N])
+{
+    return N - 1;
+}
+
+constexpr size_t kUint8Digits  = 3;
+constexpr size_t kUint16Digits = 5;
+} // namespace command_json
+
+// Writes a Command as WLED JSON, e.g. {"on":true,"bri":128,"seg":{"col":[[255,0,0]],"cct":127}}, into a caller-owned
+// buffer. Nothing is allocated and the output never exceeds kMaxBytes.
+class CommandEncoder
+{
+public:
+    static constexpr size_t kMaxBytes = 2 /* {} */ + command_json::length(command_json::kOn) +
+        command_json::length(command_json::kFalse) + 1 + command_json::length(command_json::kBrightness) +
+        command_json::kUint8Digits + 1 + command_json::length(command_json::kTransition) + command_json::kUint16Digits + 1 +
+        command_json::length(command_json::kSegment) + command_json::length(command_json::kColor) +
+        4 * command_json::kUint8Digits + 3 + command_json::length(command_json::kColorEnd) + 1 +
+        command_json::length(command_json::kCct) + command_json::kUint8Digits + 1 /* } */;
+
+    using Buffer = char[kMaxBytes];
+
+    // Returns the number of bytes written, the output is not NUL-terminated
+    static size_t encode(const Command & command, Buffer & buffer);
+
+private:
+    explicit CommandEncoder(char * buffer) : cur(buffer) {}
+
+    template <size_t N>
+    void literal(const char (&text)[N])
+    {
+        for (size_t i = 0; i < N - 1; i++)
+            *cur++ = text[i];
+    }
+
+    void character(char c) { *cur++ = c; }
+    void number(uint32_t value);
+    void separator();
+
+    char * cur;
+    bool first = true;
+};
+} // namespace wled
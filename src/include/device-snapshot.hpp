@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "state-parser.hpp"
+#include "transition.hpp"
+
+namespace wled {
+// Everything the attribute read callbacks need from a light, published as one consistent value. Plain bytes only so it
+// can go through a Seqlock; strings are truncated to what the Matter attributes can hold anyway.
+struct alignas(64) DeviceSnapshot
+{
+    // "<arch> v<version>"
+    static constexpr size_t kModelSize = 2 * ParsedState::kStringSize + 2;
+
+    bool on               = false;
+    uint8_t brightness    = 0;
+    uint8_t hue           = 0;
+    uint8_t saturation    = 0;
+    uint16_t mireds       = 0;
+    uint16_t capabilities = 0;
+
+    // Running transitions, readers interpolate against their own clock
+    Transition level_transition;
+    Transition hue_transition;
+    Transition saturation_transition;
+    Transition mireds_transition;
+
+    char manufacturer[ParsedState::kStringSize]  = {};
+    char serial_number[ParsedState::kStringSize] = {};
+    char model[kModelSize]                       = {};
+};
+} // namespace wled
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <string_view>
+
+namespace wled {
+// Fast non-cryptographic 64-bit hash (8 bytes per round, murmur-style finalizer). Only used to notice that a payload is
+// byte-for-byte the same as the previous one, so collisions just mean one update is skipped.
+inline uint64_t fingerprint(std::string_view data)
+{
+    constexpr uint64_t PRIME_1 = 0x9E3779B185EBCA87ULL;
+    constexpr uint64_t PRIME_2 = 0xC2B2AE3D27D4EB4FULL;
+
+    const char * p   = data.data();
+    size_t remaining = data.size();
+    uint64_t hash    = PRIME_1 ^ (remaining * PRIME_2);
+
+    while (remaining >= 8)
+    {
+        uint64_t word;
+        memcpy(&word, p, sizeof(word));
+        word *= PRIME_2;
+        word = (word << 31) | (word >> 33);
+        hash ^= word * PRIME_1;
+        hash = ((hash << 27) | (hash >> 37)) * PRIME_1 + PRIME_2;
+        p += 8;
+        remaining -= 8;
+    }
+
+    uint64_t tail = 0;
+    memcpy(&tail, p, remaining);
+    hash ^= tail * PRIME_2;
+
+    hash ^= hash >> 33;
+    hash *= PRIME_2;
+    hash ^= hash >> 29;
+    hash *= PRIME_1;
+    hash ^= hash >> 32;
+    return hash;
+}
+} // namespace wled
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <chrono>
+
+#include "state-parser.hpp"
+
+namespace wled {
+// What the device state should look like once a sent command has been applied
+struct Expectation
+{
+    enum Field : uint8_t
+    {
+        kOn         = 1u << 0,
+        kBrightness = 1u << 1,
+        kColor      = 1u << 2,
+        kCct        = 1u << 3,
+    };
+
+    uint8_t fields     = 0;
+    bool on            = false;
+    uint8_t brightness = 0;
+    uint8_t color[3]   = {};
+    uint8_t cct        = 0;
+    // Copied from the Command, unset for commands that didn't come through the coalescer
+    std::chrono::steady_clock::time_point received;
+    std::chrono::steady_clock::time_point flushed;
+    std::chrono::steady_clock::time_point sent;
+
+    bool matches(const ParsedState & state) const;
+};
+
+// Commands that have been written to the socket but not yet reflected in a state push. WLED applies commands in order
+// and answers each with its full state, so a push that satisfies a command also confirms every older one. Sends never
+// wait on this; it only lets the receive side tell acks apart from external changes.
+class InflightCommands
+{
+public:
+    static constexpr size_t kMaxInflight = 8;
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    // When full, the oldest command is given up on
+    void push(const Expectation & expectation);
+
+    // Retires every command confirmed by `state`, returns how many were retired. `matched` receives the newest of them,
+    // the one `state` actually answered.
+    size_t acknowledge(const ParsedState & state, Expectation * matched = nullptr);
+
+    // Drops commands the device never confirmed (e.g. it clamped or ignored a value)
+    size_t expire(std::chrono::steady_clock::time_point now, std::chrono::milliseconds timeout);
+
+    // Commands sent after `since`
+    size_t sent_since(std::chrono::steady_clock::time_point since) const;
+
+    // Fields still owed by unconfirmed commands. A push that doesn't confirm them predates the commands, so its values
+    // for these fields are stale.
+    uint8_t pending_fields() const;
+
+    void clear() { head = count = 0; }
+
+private:
+    const Expectation & at(size_t index) const { return ring[(head + index) % kMaxInflight]; }
+
+    std::array<Expectation, kMaxInflight> ring;
+    size_t head  = 0;
+    size_t count = 0;
+};
+} // namespace wled
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <app/CommandHandlerInterface.h>
+
+class WLED;
+
+namespace wled {
+// Takes MoveToLevel(WithOnOff) commands with a transition time away from the LevelControl server, which would step
+// CurrentLevel locally and write every step to the light. WLED fades natively from one command instead. Anything else
+// (Move, Step, instant moves) is left to the server.
+class LevelControlHandler : public chip::app::CommandHandlerInterface
+{
+public:
+    using Lookup = WLED * (*) (chip::EndpointId);
+
+    explicit LevelControlHandler(Lookup lookup);
+    ~LevelControlHandler() = default;
+
+    LevelControlHandler(const LevelControlHandler &)              = delete;
+    LevelControlHandler & operator=(const LevelControlHandler &)  = delete;
+    LevelControlHandler(LevelControlHandler && other)             = delete;
+    LevelControlHandler & operator=(LevelControlHandler && other) = delete;
+
+    void InvokeCommand(HandlerContext & ctx) override;
+
+private:
+    template <typename Request>
+    void move_to_level(HandlerContext & ctx, bool with_on_off);
+    void stop(HandlerContext & ctx);
+
+    Lookup lookup;
+};
+} // namespace wled
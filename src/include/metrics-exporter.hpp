@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "metrics.hpp"
+
+namespace wled {
+// Publishes a MetricsRegistry in the Prometheus text format, as a plain HTTP endpoint for scraping and/or as a file
+// rewritten every `interval` (e.g. for node_exporter's textfile collector). Runs on its own thread so a slow scraper
+// never holds up the monitor loop.
+class MetricsExporter
+{
+public:
+    struct Config
+    {
+        // 0 disables the HTTP endpoint
+        uint16_t port = 0;
+        // The endpoint lists every light's name and address and has no authentication, so it only listens on loopback
+        // unless told otherwise. Any IPv4 or IPv6 literal, "::" listens on every interface (dual-stack).
+        std::string address = "127.0.0.1";
+        // Empty disables the file
+        std::string file;
+        std::chrono::milliseconds interval{ 10000 };
+    };
+
+    explicit MetricsExporter(const MetricsRegistry & registry) : registry(registry) {}
+    ~MetricsExporter();
+
+    MetricsExporter(const MetricsExporter &)              = delete;
+    MetricsExporter & operator=(const MetricsExporter &)  = delete;
+    MetricsExporter(MetricsExporter && other)             = delete;
+    MetricsExporter & operator=(MetricsExporter && other) = delete;
+
+    // Does nothing if neither output is configured. Returns false if the port couldn't be bound.
+    bool start(const Config & config);
+
+private:
+    void run();
+    bool listen_on(const std::string & address, uint16_t port);
+    void serve(int client);
+    void write_file();
+
+    const MetricsRegistry & registry;
+    Config config;
+    int listenfd = -1;
+    int wakefd   = -1;
+    std::atomic<bool> stopping{ false };
+    std::thread thread;
+};
+} // namespace wled
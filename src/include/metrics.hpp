@@ -0,0 +1,152 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace wled {
+// Monotonic count, safe to bump from any thread
+class Counter
+{
+public:
+    void add(uint64_t n = 1) { value_.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> value_{ 0 };
+};
+
+class Gauge
+{
+public:
+    void add(int64_t n) { value_.fetch_add(n, std::memory_order_relaxed); }
+    void set(int64_t n) { value_.store(n, std::memory_order_relaxed); }
+    int64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> value_{ 0 };
+};
+
+// Latency distribution in whole microseconds, bucketed the way HdrHistogram does it: every power of two is split into
+// kSubBuckets equal steps, so a bucket is never wider than 1/kSubBuckets of the values in it. Buckets include their
+// upper edge like Prometheus' `le` does, so every power of two is the last value of a bucket. Recording is one relaxed
+// increment per bucket/count/sum and never allocates.
+class Histogram
+{
+public:
+    static constexpr unsigned kSubBucketBits = 3;
+    static constexpr size_t kSubBuckets      = size_t{ 1 } << kSubBucketBits;
+    // Anything longer (about 71 minutes) lands in the last bucket
+    static constexpr unsigned kMaxBits = 32;
+    static constexpr size_t kBuckets   = (kMaxBits - kSubBucketBits + 1) * kSubBuckets;
+
+    void record(uint64_t micros);
+    void record(std::chrono::steady_clock::duration elapsed)
+    {
+        auto micros = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+        record(static_cast<uint64_t>(micros < 0 ? 0 : micros));
+    }
+
+    uint64_t count() const { return total.load(std::memory_order_relaxed); }
+    // Microseconds
+    uint64_t sum() const { return sum_.load(std::memory_order_relaxed); }
+
+    // Observations of at most `bound`, exact when `bound` is a power of two
+    uint64_t count_at_most(uint64_t bound) const;
+
+    // Upper end of the bucket holding quantile `q` (0..1), 0 if nothing was recorded
+    uint64_t percentile(double q) const;
+
+    // Adds everything recorded in `other`, e.g. to summarize a whole fleet
+    void merge(const Histogram & other);
+
+    static size_t bucket(uint64_t micros);
+    static uint64_t bucket_lower(size_t index) { return index == 0 ? 0 : edge(index) + 1; }
+    static uint64_t bucket_upper(size_t index) { return edge(index + 1); }
+
+private:
+    // Upper edge of bucket `index - 1`
+    static uint64_t edge(size_t index);
+
+    std::array<std::atomic<uint64_t>, kBuckets> buckets{};
+    std::atomic<uint64_t> total{ 0 };
+    std::atomic<uint64_t> sum_{ 0 };
+};
+
+// Legs of a command's trip from Matter to the light, timed for every command the light confirms
+enum class CommandStage : uint8_t
+{
+    // Matter write arrived -> coalescer flushed the command, includes time held back while the light was congested
+    kCoalesce,
+    // Flushed -> the socket accepted it
+    kSend,
+    // Sent -> the light's state push confirmed it
+    kDevice,
+    // Matter write arrived -> confirmed
+    kTotal,
+    kCount,
+};
+
+// Everything measured for one light. The light owns it and registers it with the registry for its lifetime.
+struct DeviceMetrics
+{
+    // Handing a command to the websocket or UDP socket
+    Histogram send_latency;
+    // Parsing one state push
+    Histogram parse_time;
+    std::array<Histogram, static_cast<size_t>(CommandStage::kCount)> stages;
+
+    Histogram & stage(CommandStage which) { return stages[static_cast<size_t>(which)]; }
+
+    // Writes merged into the pending command, versus commands that actually went out
+    Counter commands_submitted;
+    Counter commands_sent;
+    // Sent but never confirmed, e.g. the light clamped a value
+    Counter commands_unconfirmed;
+    Counter reconnect_attempts;
+
+    std::atomic<bool> reachable{ false };
+};
+
+// Collects the bridge's metrics and renders them in the Prometheus text format. Only registration and rendering take
+// the lock, updates go straight to the atomics.
+class MetricsRegistry
+{
+public:
+    MetricsRegistry() = default;
+
+    MetricsRegistry(const MetricsRegistry &)              = delete;
+    MetricsRegistry & operator=(const MetricsRegistry &)  = delete;
+    MetricsRegistry(MetricsRegistry && other)             = delete;
+    MetricsRegistry & operator=(MetricsRegistry && other) = delete;
+
+    // `name` is asked for on every render, a light's name can change while it's connected
+    void add(DeviceMetrics & metrics, std::string address, std::function<std::string()> name);
+    void remove(DeviceMetrics & metrics);
+
+    void render(std::string & out) const;
+
+    // Attribute changes marked but not yet reported to Matter
+    Gauge report_backlog;
+    // First to last send of a room action
+    Histogram room_send_skew;
+
+private:
+    struct Entry
+    {
+        DeviceMetrics * metrics;
+        std::string address;
+        std::function<std::string()> name;
+    };
+
+    mutable std::mutex mutex;
+    std::vector<Entry> devices;
+};
+} // namespace wled
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+#include "reactor.hpp"
+#include "timer-wheel.hpp"
+
+class WLED;
+
+namespace wled {
+// The loop behind the monitor thread, shared by the bridge and the benchmark. Every connected light's socket is
+// registered with the reactor, readiness is handed to WLED::update() and the timer wheel runs in between. The set of
+// lights is only looked at again when the monitor pipe is poked, i.e. a light was added, removed or reconnected.
+class Monitor
+{
+public:
+    // Fills in the lights to follow, called on the monitor thread with whatever locking the owner of the list needs
+    using LightSource = std::function<void(std::vector<WLED *> & lights)>;
+
+    Monitor(Reactor & reactor, TimerWheel & timers, int pipe_fd, LightSource lights, std::chrono::milliseconds keepalive_budget);
+
+    Monitor(const Monitor &)              = delete;
+    Monitor & operator=(const Monitor &)  = delete;
+    Monitor(Monitor && other)             = delete;
+    Monitor & operator=(Monitor && other) = delete;
+
+    // Runs `handler` on the monitor thread whenever `fd` is readable, the lights are synced again afterwards. Must be
+    // called before run().
+    void watch(int fd, std::function<void()> handler);
+
+    // Loops until stop()
+    void run();
+    // Safe from any thread
+    void stop();
+
+private:
+    struct Registration
+    {
+        int fd;
+        uint32_t generation;
+    };
+
+    struct Watched
+    {
+        int fd;
+        std::function<void()> handler;
+    };
+
+    void sync_registrations();
+
+    Reactor & reactor;
+    TimerWheel & timers;
+    int pipe_fd;
+    LightSource lights;
+    std::chrono::milliseconds keepalive_budget;
+
+    // Stable addresses, they are the reactor contexts
+    std::deque<Watched> watched;
+    std::unordered_map<WLED *, Registration> registered;
+    std::vector<WLED *> current;
+    std::atomic<bool> stopping{ false };
+};
+} // namespace wled
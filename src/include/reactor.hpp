@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <sys/epoll.h>
+
+namespace wled {
+// Thin wrapper around an epoll instance. File descriptors are registered once with an opaque context pointer which is
+// handed back for every ready event, so dispatch only touches descriptors that actually have something to do.
+// wake() interrupts a wait() from any thread, e.g. after a timer was scheduled earlier than the current timeout.
+class Reactor
+{
+public:
+    Reactor();
+    ~Reactor();
+
+    Reactor(const Reactor &)              = delete;
+    Reactor & operator=(const Reactor &)  = delete;
+    Reactor(Reactor && other)             = delete;
+    Reactor & operator=(Reactor && other) = delete;
+
+    bool add(int fd, uint32_t events, void * context);
+    bool modify(int fd, uint32_t events, void * context);
+    void remove(int fd);
+
+    // Returns the number of ready events written to `events`, 0 on timeout or wake(). A negative timeout blocks
+    // indefinitely.
+    int wait(struct epoll_event * events, int max_events, int timeout_ms);
+    void wake();
+
+private:
+    int epfd   = -1;
+    int wakefd = -1;
+};
+} // namespace wled
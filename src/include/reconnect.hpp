@@ -0,0 +1,107 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "reactor.hpp"
+#include "timer-wheel.hpp"
+
+namespace wled {
+// Brings disconnected lights back for the whole bridge. Backoff timers live on the shared timer wheel and the attempts
+// themselves run on a small fixed pool of workers, so at most `max_attempts` connections are in flight no matter how
+// many lights dropped at once. Delays are jittered so lights that went down together don't come back in lockstep.
+class ReconnectManager
+{
+public:
+    using Clock = TimerWheel::Clock;
+
+    struct Config
+    {
+        size_t max_attempts = 4;
+        std::chrono::milliseconds initial_backoff{ 5000 };
+        std::chrono::milliseconds max_backoff{ 5 * 60 * 1000 };
+    };
+
+    class Target
+    {
+    public:
+        Target();
+        // Blocks until an attempt that is already running has finished
+        virtual ~Target();
+
+        // One bounded, blocking connection attempt. Returns true once the target is usable again.
+        virtual bool reconnect_attempt() = 0;
+        virtual const char * reconnect_name() = 0;
+
+    private:
+        friend class ReconnectManager;
+        static void on_timer(void * context);
+
+        enum class State
+        {
+            Idle,
+            Waiting,
+            Queued,
+            Attempting,
+        };
+
+        ReconnectManager * owner = nullptr;
+        TimerWheel::Timer timer;
+        State state = State::Idle;
+        std::chrono::milliseconds backoff{ 0 };
+    };
+
+    ReconnectManager(TimerWheel & timers, Reactor & reactor) : timers(timers), reactor(reactor) {}
+    ~ReconnectManager();
+
+    ReconnectManager(const ReconnectManager &)              = delete;
+    ReconnectManager & operator=(const ReconnectManager &)  = delete;
+    ReconnectManager(ReconnectManager && other)             = delete;
+    ReconnectManager & operator=(ReconnectManager && other) = delete;
+
+    // Starts the workers, must be called once before anything is scheduled
+    void configure(const Config & config);
+
+    // Does nothing if the target is already being reconnected
+    void schedule(Target & target);
+    // Like schedule(), but the first attempt is queued for the workers right away. Used to bring lights up for the
+    // first time without a thread per light.
+    void start(Target & target);
+    void cancel(Target & target);
+
+    // Targets waiting for or in the middle of an attempt
+    size_t pending() const { return pending_count.load(std::memory_order_relaxed); }
+    uint64_t failed() const { return failed_count.load(std::memory_order_relaxed); }
+    uint64_t succeeded() const { return succeeded_count.load(std::memory_order_relaxed); }
+
+private:
+    void due(Target & target);
+    void arm(Target & target, Clock::time_point now);
+    void worker();
+
+    TimerWheel & timers;
+    Reactor & reactor;
+    Config config;
+
+    std::mutex mutex;
+    std::condition_variable ready_cv;
+    std::condition_variable attempt_done_cv;
+    std::deque<Target *> ready;
+    std::vector<std::thread> workers;
+    std::minstd_rand rng{ std::random_device{}() };
+    bool stopping = false;
+
+    std::atomic<size_t> pending_count{ 0 };
+    std::atomic<uint64_t> failed_count{ 0 };
+    std::atomic<uint64_t> succeeded_count{ 0 };
+};
+} // namespace wled
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+
+namespace wled {
+// Publishes a small value to readers on other threads. Readers never take a lock and never block a writer, they only
+// retry if a store overlapped their copy. Writers are serialized among themselves.
+template <typename T>
+class Seqlock
+{
+    static_assert(std::is_trivially_copyable_v<T>, "Seqlock values are copied byte for byte");
+
+public:
+    Seqlock() = default;
+
+    Seqlock(const Seqlock &)              = delete;
+    Seqlock & operator=(const Seqlock &)  = delete;
+    Seqlock(Seqlock && other)             = delete;
+    Seqlock & operator=(Seqlock && other) = delete;
+
+    void store(const T & value)
+    {
+        std::lock_guard lock(writer);
+        uint32_t sequence = version.load(std::memory_order_relaxed);
+        // Odd while the copy is in progress
+        version.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy(&data, &value, sizeof(T));
+        version.store(sequence + 2, std::memory_order_release);
+    }
+
+    T load() const
+    {
+        T value;
+        while (true)
+        {
+            uint32_t before = version.load(std::memory_order_acquire);
+            if (before & 1)
+            {
+                // The writer may have been preempted mid-copy
+                std::this_thread::yield();
+                continue;
+            }
+            memcpy(&value, &data, sizeof(T));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (version.load(std::memory_order_relaxed) == before)
+                return value;
+        }
+    }
+
+private:
+    // Readers poll the version, keep the writer's mutex off its cache line
+    alignas(64) std::atomic<uint32_t> version{ 0 };
+    alignas(64) T data{};
+    std::mutex writer;
+};
+} // namespace wled
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <array>
+#include <atomic>
+
+namespace wled {
+// Bounded single-producer/single-consumer queue of fixed-size items. Neither side ever blocks or allocates: a full ring
+// makes push() fail and counts it, the producer decides what to do instead. Producers may take turns as long as
+// something else (e.g. a mutex) keeps them from pushing at the same time.
+template <typename T, size_t N>
+class SpscRing
+{
+    static_assert(N > 0 && (N & (N - 1)) == 0, "Ring size must be a power of two");
+
+public:
+    SpscRing() = default;
+
+    SpscRing(const SpscRing &)              = delete;
+    SpscRing & operator=(const SpscRing &)  = delete;
+    SpscRing(SpscRing && other)             = delete;
+    SpscRing & operator=(SpscRing && other) = delete;
+
+    // Producer side
+    bool push(const T & item)
+    {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == N)
+        {
+            overflow_count.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        slots[t & (N - 1)] = item;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side
+    bool pop(T & item)
+    {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire))
+            return false;
+        item = slots[h & (N - 1)];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Pushes that found the ring full
+    size_t overflows() const { return overflow_count.load(std::memory_order_relaxed); }
+
+private:
+    // Each index on its own cache line so the two threads don't false-share
+    alignas(64) std::atomic<size_t> head{ 0 };
+    alignas(64) std::atomic<size_t> tail{ 0 };
+    alignas(64) std::atomic<size_t> overflow_count{ 0 };
+    std::array<T, N> slots{};
+};
+} // namespace wled
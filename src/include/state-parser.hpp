@@ -0,0 +1,88 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string_view>
+
+namespace wled {
+// Fields the bridge cares about in a WLED state push, `present` says which were actually found
+struct ParsedState
+{
+    enum Field : uint32_t
+    {
+        kOn           = 1u << 0,
+        kBrightness   = 1u << 1,
+        kColor        = 1u << 2,
+        kCct          = 1u << 3,
+        kCapabilities = 1u << 4,
+        kName         = 1u << 5,
+        kMac          = 1u << 6,
+        kArch         = 1u << 7,
+        kVersion      = 1u << 8,
+        kTransition   = 1u << 9,
+    };
+
+    static constexpr size_t kStringSize = 33;
+
+    uint32_t present = 0;
+
+    bool on            = false;
+    uint8_t brightness = 0;
+    // Primary color of the first segment, r/g/b/w
+    uint8_t color[4]    = {};
+    uint8_t color_count = 0;
+    uint16_t cct        = 0;
+    // Default transition, in 100ms units
+    uint16_t transition = 0;
+
+    int capabilities          = 0;
+    char name[kStringSize]    = {};
+    char mac[kStringSize]     = {};
+    char arch[kStringSize]    = {};
+    char version[kStringSize] = {};
+
+    bool has(Field field) const { return (present & field) != 0; }
+};
+
+// On-demand pull parser for WLED's {"state":{...},"info":{...}} documents. Only the paths in ParsedState are decoded,
+// everything else is skipped without building a DOM or allocating.
+class StateParser
+{
+public:
+    // `with_info` = false skips the whole info object, it only changes across reconnects
+    static bool parse(std::string_view json, bool with_info, ParsedState & out);
+
+    // Finds the raw text of a top-level member's value without decoding it
+    static bool find_member(std::string_view json, std::string_view key, std::string_view & value);
+
+private:
+    explicit StateParser(std::string_view json) : cur(json.data()), end(json.data() + json.size()) {}
+
+    bool parse_root(bool with_info, ParsedState & out);
+    bool parse_state(ParsedState & out);
+    bool parse_segments(ParsedState & out);
+    bool parse_segment(ParsedState & out);
+    bool parse_color(ParsedState & out);
+    bool parse_info(ParsedState & out);
+    bool parse_leds(ParsedState & out);
+
+    // Walk an object/array, the callback must consume the member's value
+    template <typename F>
+    bool for_each_member(F && on_member);
+    template <typename F>
+    bool for_each_element(F && on_element);
+
+    bool parse_bool(bool & value);
+    bool parse_uint(uint32_t & value);
+    bool parse_string(char * buffer, size_t size);
+    bool skip_value();
+    bool skip_string();
+
+    bool expect(char c);
+    void skip_whitespace();
+
+    const char * cur;
+    const char * end;
+};
+} // namespace wled
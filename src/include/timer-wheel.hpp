@@ -0,0 +1,94 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace wled {
+// Hashed timer wheel driven by the monitor loop: the loop sleeps until next_timeout() and then calls advance(). Timers
+// are intrusive so scheduling never allocates. schedule()/cancel() may be called from any thread, callbacks run on the
+// thread calling advance() without the wheel locked, so they are free to reschedule themselves. Once cancel() returns the
+// timer's callback is neither pending nor running, so whatever owns the timer may be destroyed.
+class TimerWheel
+{
+public:
+    using Clock    = std::chrono::steady_clock;
+    using Callback = void (*)(void * context);
+
+    static constexpr std::chrono::milliseconds kTick{ 5 };
+    static constexpr size_t kSlots = 256;
+
+    struct Timer
+    {
+        Timer() = default;
+        Timer(Callback aCallback, void * aContext) : callback(aCallback), context(aContext) {}
+
+        Callback callback = nullptr;
+        void * context    = nullptr;
+
+    private:
+        friend class TimerWheel;
+
+        enum class State : uint8_t
+        {
+            kIdle,
+            // Linked into a slot
+            kArmed,
+            // Due, linked into the wheel's fired list until advance() gets to it
+            kFired,
+        };
+
+        uint64_t expires = 0;
+        Timer * next     = nullptr;
+        Timer * prev     = nullptr;
+        State state      = State::kIdle;
+    };
+
+    TimerWheel();
+
+    TimerWheel(const TimerWheel &)              = delete;
+    TimerWheel & operator=(const TimerWheel &)  = delete;
+    TimerWheel(TimerWheel && other)             = delete;
+    TimerWheel & operator=(TimerWheel && other) = delete;
+
+    // (Re)arms `timer`. Returns true if it is now the earliest timer, i.e. the loop has to be woken up to honor it.
+    bool schedule(Timer & timer, Clock::time_point when);
+    // Waits for the timer's callback if it is running on another thread, so it must not be called with a lock held that
+    // the callback takes
+    void cancel(Timer & timer);
+    bool is_scheduled(const Timer & timer);
+
+    // Milliseconds until the next timer is due, -1 if there is none
+    int next_timeout(Clock::time_point now);
+    // Fires everything that is due
+    void advance(Clock::time_point now);
+
+private:
+    uint64_t to_tick(Clock::time_point when) const;
+    void link(Timer & timer);
+    void unlink(Timer & timer);
+    void queue(Timer & timer);
+    void dequeue(Timer & timer);
+    void detach(Timer & timer);
+    uint64_t earliest_tick() const;
+
+    std::mutex mutex;
+    Clock::time_point origin;
+    uint64_t current_tick = 0;
+    size_t armed          = 0;
+    Timer * slots[kSlots] = {};
+
+    // Due timers whose callbacks haven't run yet, oldest first. Linked through the same fields as the slots, a timer is
+    // only ever on one list.
+    Timer * fired_head = nullptr;
+    Timer * fired_tail = nullptr;
+    // The callback running right now and the thread running it, cancel() waits on `fired_cv` for it to return
+    Timer * firing = nullptr;
+    std::thread::id advancing;
+    std::condition_variable fired_cv;
+};
+} // namespace wled
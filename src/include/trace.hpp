@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace wled {
+// Binary event log for the hot paths. Every thread appends fixed-size records to a ring of its own, so recording is a
+// clock read and a few stores with no locks and no formatting. Text is only produced when the rings are dumped, which
+// happens on request (bridge.py trace) or when the process dies on a fatal signal.
+namespace trace {
+
+constexpr size_t kRecordsPerThread = 1024;
+constexpr size_t kMaxThreads       = 32;
+
+enum class Event : uint16_t
+{
+    // a: thread id
+    kThreadStart,
+    // a: endpoint | transition << 16, b: the command packed by pack_command(), name: "ws" or "udp"
+    kSend,
+    // a: endpoint, b: value (length for strings), name: cluster::attribute
+    kAttributeRead,
+    kAttributeWrite,
+    // a: endpoint, b: epoll events
+    kReadyToUpdate,
+    // a: endpoint, b: the stages packed by pack_stages()
+    kCommandConfirmed,
+};
+
+// `name` must outlive the process, it is only dereferenced when dumping
+void record(Event event, uint32_t a = 0, uint64_t b = 0, const char * name = nullptr);
+
+// fields, on, brightness, r, g, b, w and cct, one byte each
+constexpr uint64_t pack_command(uint8_t fields, bool on, uint8_t brightness, const uint8_t (&color)[4], uint8_t cct)
+{
+    return uint64_t{ fields } | uint64_t{ on } << 8 | uint64_t{ brightness } << 16 | uint64_t{ color[0] } << 24 |
+        uint64_t{ color[1] } << 32 | uint64_t{ color[2] } << 40 | uint64_t{ color[3] } << 48 | uint64_t{ cct } << 56;
+}
+
+// Coalesce, send and device stage in microseconds, 21 bits each (saturating at ~2.1s)
+constexpr uint64_t kStageBits = 21;
+constexpr uint64_t pack_stages(uint64_t coalesce, uint64_t send, uint64_t device)
+{
+    constexpr uint64_t max = (uint64_t{ 1 } << kStageBits) - 1;
+    return (coalesce < max ? coalesce : max) | (send < max ? send : max) << kStageBits |
+        (device < max ? device : max) << (2 * kStageBits);
+}
+
+// Writes every thread's records as text, oldest first within each thread. Only async-signal-safe calls are used, so
+// this can run from a signal handler while other threads keep recording.
+void dump(int fd);
+
+// Dumps to stderr when the process receives a fatal signal, then lets the signal take its course
+void install_crash_handler();
+
+// Records dropped because more than kMaxThreads threads were recording at once
+size_t dropped();
+
+} // namespace trace
+} // namespace wled
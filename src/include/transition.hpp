@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <chrono>
+
+namespace wled {
+// Linear fade between two values. WLED runs the real fade from `tt`, this only tracks where it should be so Matter
+// attributes can follow along without a frame per step.
+class Transition
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    void start(int32_t from, int32_t to, std::chrono::milliseconds duration, Clock::time_point now);
+    void stop() { running = false; }
+
+    // False once the end has passed or after stop()
+    bool active(Clock::time_point now) const { return running && now < end; }
+    int32_t value(Clock::time_point now) const;
+    int32_t target() const { return to; }
+    Clock::time_point finish() const { return end; }
+    // In tenths of a second, rounded up, like Matter's RemainingTime
+    uint16_t remaining(Clock::time_point now) const;
+
+private:
+    int32_t from = 0;
+    int32_t to   = 0;
+    Clock::time_point begin;
+    Clock::time_point end;
+    bool running = false;
+};
+} // namespace wled
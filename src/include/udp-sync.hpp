@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+namespace wled {
+// Sender side of WLED's UDP notifier protocol. One datagram carries on/off, brightness and the primary color, so hot
+// attributes skip the JSON API entirely. Nothing comes back over UDP, state is still read from the WebSocket.
+//
+// The receiving WLED needs "Receive Brightness/Color" enabled in its sync settings. "Receive Effects" should be off,
+// the packet always describes the Solid effect.
+class UdpSync
+{
+public:
+    static constexpr uint16_t kPort = 21324;
+
+    UdpSync() = default;
+    ~UdpSync();
+
+    UdpSync(const UdpSync &)              = delete;
+    UdpSync & operator=(const UdpSync &)  = delete;
+    UdpSync(UdpSync && other)             = delete;
+    UdpSync & operator=(UdpSync && other) = delete;
+
+    int open(const std::string & host, uint16_t port = kPort);
+    void close();
+    bool is_open() const { return sockfd >= 0; }
+
+    // `color` is r/g/b/w. A brightness of 0 turns the light off.
+    int send_state(uint8_t brightness, const uint8_t color[4], uint16_t transition_ms);
+
+private:
+    static constexpr size_t kPacketSize = 41;
+
+    int sockfd = -1;
+    uint8_t packet[kPacketSize];
+};
+} // namespace wled
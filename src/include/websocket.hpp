@@ -0,0 +1,88 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace wled {
+// Minimal non-blocking RFC 6455 client. It owns its socket and buffers and never blocks: connect() only starts the TCP
+// connection, and the owner drives it forward from its event loop with on_writable()/on_readable(). Not thread-safe,
+// callers are expected to serialize access.
+class WebSocket
+{
+public:
+    enum class State
+    {
+        Closed,
+        Connecting,
+        Handshaking,
+        Open,
+    };
+
+    explicit WebSocket(size_t max_message_bytes);
+    ~WebSocket();
+
+    WebSocket(const WebSocket &)              = delete;
+    WebSocket & operator=(const WebSocket &)  = delete;
+    WebSocket(WebSocket && other)             = delete;
+    WebSocket & operator=(WebSocket && other) = delete;
+
+    // Starts a connection to ws://host:port/path. Returns 0 if the connection is in progress.
+    int connect(const std::string & host, uint16_t port, const std::string & path);
+    void close();
+
+    int fd() const { return sockfd; }
+    State state() const { return current_state; }
+    bool is_open() const { return current_state == State::Open; }
+    // When bytes last arrived, or when the connection was started. Pongs count, so a ping is enough to refresh it.
+    std::chrono::steady_clock::time_point last_activity() const { return last_receive; }
+
+    // Both return -1 once the connection is unusable, after which the socket has been closed. on_readable() returns 1
+    // if it stopped because the receive buffer is full, the caller should drain messages and call it again.
+    int on_writable();
+    int on_readable();
+
+    // Pops the next complete data message. The view stays valid until the next call to on_readable().
+    // Control frames are handled internally. Returns false when no complete message is buffered.
+    bool next_message(std::string_view & message);
+
+    int send_text(const char * data, size_t length);
+    // Bytes queued because the socket would block, they go out on the next on_writable()
+    size_t unsent() const { return outbuf.size() - opos; }
+    int send_ping();
+
+private:
+    int send_frame(uint8_t opcode, const char * data, size_t length);
+    int flush();
+    int parse_handshake();
+    int fail();
+
+    int sockfd                  = -1;
+    State current_state         = State::Closed;
+    const size_t max_message    = 0;
+    std::string expected_accept = "";
+    std::string request_path    = "";
+    std::string request_host    = "";
+
+    std::vector<char> inbuf;
+    size_t rpos = 0;
+    size_t wpos = 0;
+
+    std::vector<char> outbuf;
+    size_t opos = 0;
+
+    // Message being reassembled from fragments
+    std::vector<char> fragments;
+    bool fragmenting = false;
+    // Reassembled messages handed out since the last on_readable(), kept so their views stay valid until then
+    std::vector<std::vector<char>> assembled;
+
+    uint32_t mask_state = 0;
+
+    std::chrono::steady_clock::time_point last_receive;
+};
+} // namespace wled
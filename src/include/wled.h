@@ -17,514 +17,1239 @@
  */
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cstdint>
 #include <cstring>
-#include <future>
+#include <functional>
+#include <initializer_list>
 #include <iostream>
 #include <mutex>
+#include <poll.h>
 #include <string>
 #include <string_view>
-#include <sys/select.h>
+#include <sys/epoll.h>
+#include <thread>
 #include <unistd.h>
 #include <utility>
 
-#include <curl/curl.h>
-#include <json/json.h>
-
 #include "Device.h"
+#include "coalescer.hpp"
+#include "device-snapshot.hpp"
+#include "color-accumulator.hpp"
+#include "command.hpp"
 #include "color-utils.h"
+#include "fingerprint.hpp"
+#include "inflight.hpp"
+#include "metrics.hpp"
+#include "reactor.hpp"
+#include "reconnect.hpp"
+#include "seqlock.hpp"
+#include "state-parser.hpp"
+#include "timer-wheel.hpp"
+#include "trace.hpp"
+#include "transition.hpp"
+#include "udp-sync.hpp"
+#include "websocket.hpp"
 
 #define BIT_SET(n, x) (((n & (1 << x)) != 0) ? 1 : 0)
 #define SUPPORTS_RGB(x) BIT_SET(x, 0)
 #define SUPPORTS_WHITE_CHANNEL(x) BIT_SET(x, 1)
 #define SUPPORTS_COLOR_TEMPERATURE(x) BIT_SET(x, 2)
 
-class WLED : public DeviceExtendedColor
+// Shared by all lights, flushes run on the WLED monitor thread
+extern wled::Coalescer gCoalescer;
+extern wled::MetricsRegistry gMetrics;
+extern wled::ReconnectManager gReconnects;
+extern wled::TimerWheel gTimerWheel;
+extern wled::Reactor gReactor;
+
+class WLED : public DeviceExtendedColor, public wled::Coalescer::Target, public wled::ReconnectManager::Target
 {
 public:
-    WLED(std::string_view aIp, std::string szLocation) noexcept :
+    // With `aStart` = false nothing touches the network until Start(), so many lights can be brought up in parallel
+    WLED(std::string_view aIp, std::string szLocation, bool aStart = true) noexcept :
         DeviceExtendedColor(("WLED " + std::string(aIp)).c_str(), szLocation), ip(aIp)
     {
-        websocket_addr = [&]() {
-            std::string temp = "ws://";
-            temp.append(aIp);
-            temp.append("/ws");
-            return temp;
-        }();
+        parse_address(ip);
+        gMetrics.add(metrics, ip, [this] { return std::string(GetName()); });
+
+        if (aStart)
+            Start();
+    }
 
-        if (connect())
+    // Blocks for at most CONNECT_TIMEOUT_MS. A light that isn't up by then keeps trying in the background.
+    void Start() noexcept
+    {
+        if (connect() || wait_for_state())
         {
             std::cerr << "Could not setup websocket connection" << std::endl;
-            using namespace std::chrono_literals;
-            if (reconnect_future.valid() && reconnect_future.wait_for(0s) != std::future_status::ready)
-                return;
-
-            reconnect_future = std::async(std::launch::async, [=] { this->reconnect(); });
-            return;
+            gReconnects.schedule(*this);
         }
-        wait();
-        recv();
     }
 
-    virtual ~WLED() noexcept
+    // Start() on one of gReconnects' workers. `started` runs there once the first attempt is over, connected or not.
+    void StartAsync(std::function<void(WLED &)> aStarted)
     {
-        // TODO: (void)curl_ws_send(curl, "", 0, &sent, 0, CURLWS_CLOSE);
-        curl_easy_cleanup(curl);
+        started = std::move(aStarted);
+        gReconnects.start(*this);
     }
 
-    int socket() const noexcept
+    virtual ~WLED() noexcept
     {
-        int sockfd   = -1;
-        CURLcode res = curl_easy_getinfo(curl, CURLINFO_ACTIVESOCKET, &sockfd);
-        if (res != CURLE_OK)
-        {
-            std::cerr << "curl_easy_getinfo(CURLINFO_ACTIVESOCKET): " << curl_easy_strerror(res) << std::endl;
-            abort();
-            return -1;
-        }
-        return sockfd;
+        // The base classes cancel their own timers too, but only after the members the callbacks use are gone
+        gCoalescer.cancel(*this);
+        gReconnects.cancel(*this);
+        gTimerWheel.cancel(level_timer);
+        gTimerWheel.cancel(color_timer);
+        DisarmKeepalive();
+        gMetrics.remove(metrics);
     }
 
-    void update() noexcept
+    int socket() const noexcept { return ws.fd(); }
+
+    // Bumped on every successful connect so the monitor loop can tell when the socket needs to be registered again,
+    // even if the kernel hands back the same descriptor number
+    uint32_t generation() const noexcept { return connection_generation; }
+
+    // `events` are the epoll events the monitor loop saw for socket()
+    void update(uint32_t events = EPOLLIN) noexcept
     {
-        recv();
+        int result = recv(events);
+        // An ack or a drained socket may be what a held back write was waiting for
+        if (result >= 0 && held_back.exchange(false))
+            flush();
+        if (result <= 0)
+            return;
         // TODO: Handle this a little more elegantly
         if (led_info.name.c_str())
             Device::SetName(led_info.name.c_str());
         DeviceOnOff::SetOnOff(led_state.on);
-        DeviceDimmable::SetLevel(led_state.brightness);
-        DeviceColorTemperature::SetMireds(cct_to_mireds(led_state.cct));
-        DeviceExtendedColor::SetHue(led_state.hsv.h);
-        DeviceExtendedColor::SetSaturation(led_state.hsv.s);
+        // Mid-transition WLED already reports the target, CurrentLevel follows level_tick() instead
+        if (!transition_active(level_transition))
+            DeviceDimmable::SetLevel(led_state.brightness);
+        if (!transition_active(mireds_transition))
+            DeviceColorTemperature::SetMireds(led_state.mireds);
+        if (!transition_active(hue_transition))
+            DeviceExtendedColor::SetHue(led_state.hsv.h);
+        if (!transition_active(saturation_transition))
+            DeviceExtendedColor::SetSaturation(led_state.hsv.s);
     }
 
-    inline std::string GetManufacturer() override { return led_info.manufacturer; }
-    inline std::string GetSerialNumber() override { return led_info.serial_number; }
-    inline std::string GetModel() override { return led_info.model; }
+    inline std::string GetManufacturer() override { return Snapshot().manufacturer; }
+    inline std::string GetSerialNumber() override { return Snapshot().serial_number; }
+    inline std::string GetModel() override { return Snapshot().model; }
+
+    // What the attribute read callbacks see. Never blocks on the monitor thread or on a write in progress.
+    wled::DeviceSnapshot Snapshot() const { return snapshot.load(); }
 
     inline std::string GetIP() { return ip; }
 
+    const wled::DeviceMetrics & Metrics() const { return metrics; }
+
+    // The monitor loop arms this whenever it starts watching a connection. A budget of 0 disables it.
+    void ArmKeepalive(wled::TimerWheel & timers, std::chrono::milliseconds budget)
+    {
+        if (budget.count() <= 0)
+            return;
+        keepalive_wheel  = &timers;
+        keepalive_budget = budget;
+        timers.schedule(keepalive_timer, std::chrono::steady_clock::now() + budget / 3);
+    }
+
+    void DisarmKeepalive()
+    {
+        if (keepalive_wheel)
+            keepalive_wheel->cancel(keepalive_timer);
+    }
+
+    void EnableUdpSync()
+    {
+        if (udp.open(host))
+            ChipLogError(DeviceLayer, "[%s] Could not enable UDP sync", GetName());
+        else
+            ChipLogProgress(DeviceLayer, "[%s] Using UDP sync on port %u", GetName(), wled::UdpSync::kPort);
+    }
+
     void SetReachable(bool reachable) override
     {
-        if (!reachable && curl)
+        if (!reachable)
         {
-            curl_easy_cleanup(curl);
-            curl = 0;
+            std::lock_guard lock(mutex);
+            ws.close();
         }
+        metrics.reachable = reachable;
         Device::SetReachable(reachable);
     }
 
     void AnimateIdentify() override
     {
-        Json::Value root;
-        bool state = !IsOn();
+        wled::Command command;
+        command.fields     = wled::Command::kOn | wled::Command::kTransition;
+        command.transition = 1;
+        bool state         = !IsOn();
         do
         {
             for (int i = 0; i < 4; i++)
             {
-                root["on"] = state;
-                root["tt"] = 1;
-                send(writer.write(root));
+                command.on = state;
+                send(command);
                 std::this_thread::sleep_for(std::chrono::milliseconds(250));
                 state = !state;
             }
         } while (--remaining_time);
     }
 
-    bool IsOn() override { return on(); }
+    bool IsOn() override { return Snapshot().on; }
     void SetOnOff(bool aOn) override
     {
         set_on(aOn);
         DeviceOnOff::SetOnOff(aOn);
     }
 
-    uint8_t Level() override { return brightness(); }
+    // A command that has been fully serialized ahead of time so a whole room can go out back-to-back
+    struct Staged
+    {
+        wled::CommandEncoder::Buffer payload;
+        size_t length;
+        wled::Expectation expectation;
+    };
+
+    // Folds `aOn` into whatever is still waiting to be coalesced and takes it all out of the coalescer
+    Staged StageOnOff(bool aOn)
+    {
+        gCoalescer.cancel(*this);
+        led_state.on = aOn;
+        publish();
+        DeviceOnOff::SetOnOff(aOn);
+
+        std::lock_guard guard(pipeline_mutex);
+        wled::Command command;
+        command.fields = wled::Command::kOn;
+        command.on     = aOn;
+        merge_pending(command);
+        resolve_color();
+
+        Staged staged;
+        staged.length      = wled::CommandEncoder::encode(pending, staged.payload);
+        staged.expectation = pending.expectation();
+        pending            = {};
+        return staged;
+    }
+
+    int SendStaged(const Staged & staged) { return transmit(staged.payload, staged.length, staged.expectation); }
+
+    uint8_t Level() override
+    {
+        auto now   = std::chrono::steady_clock::now();
+        auto state = Snapshot();
+        if (state.level_transition.active(now))
+            return static_cast<uint8_t>(state.level_transition.value(now));
+        return state.brightness;
+    }
+
     void SetLevel(uint8_t aLevel) override
     {
+        cancel_level_transition();
         set_brightness(aLevel);
         DeviceDimmable::SetLevel(aLevel);
     }
 
-    uint16_t Capabilities() override
+    uint16_t LevelRemainingTime() override
     {
-        int caps = 0;
-        // There doesn't seem to be a way in Matter to control a white channel
-        if (SUPPORTS_RGB(led_info.capabilities))
+        std::lock_guard lock(transition_mutex);
+        return level_transition.remaining(std::chrono::steady_clock::now());
+    }
+
+    // MoveToLevel(WithOnOff) with a transition time, in tenths of a second. WLED runs the fade itself from `tt` while
+    // CurrentLevel and RemainingTime are interpolated here and reported about once a second.
+    void MoveToLevel(uint8_t aLevel, uint16_t aTransitionTime, bool aWithOnOff)
+    {
+        // Matter max level is 254, WLED is 255
+        aLevel   = std::min(aLevel, static_cast<uint8_t>(254));
+        auto now = std::chrono::steady_clock::now();
         {
-            caps += static_cast<int>(chip::app::Clusters::ColorControl::ColorCapabilities::HueSaturationSupported);
+            uint8_t from = Level();
+            std::lock_guard lock(transition_mutex);
+            level_transition.start(from, aLevel, std::chrono::milliseconds(aTransitionTime * 100), now);
         }
-        if (SUPPORTS_COLOR_TEMPERATURE(led_info.capabilities))
+
+        wled::Command command;
+        command.fields       = wled::Command::kBrightness | wled::Command::kTransition;
+        command.brightness   = aLevel;
+        command.transition   = aTransitionTime;
+        led_state.brightness = aLevel;
+        if (aWithOnOff)
         {
-            caps += static_cast<int>(chip::app::Clusters::ColorControl::ColorCapabilities::ColorTemperatureSupported);
+            led_state.on = aLevel > 0;
+            DeviceOnOff::SetOnOff(led_state.on);
         }
-        return static_cast<uint16_t>(caps);
+        pipeline_send(command);
+
+        schedule_timer(level_timer, now + TRANSITION_REPORT_INTERVAL);
     }
 
-    uint16_t Mireds() override { return cct_to_mireds(led_state.cct); }
+    // Stop(WithOnOff): freezes a running level transition where it is. Returns false if there was none.
+    bool StopLevelTransition()
+    {
+        uint8_t level;
+        {
+            auto now = std::chrono::steady_clock::now();
+            std::lock_guard lock(transition_mutex);
+            if (!level_transition.active(now))
+                return false;
+            level = static_cast<uint8_t>(level_transition.value(now));
+            level_transition.stop();
+        }
+        gTimerWheel.cancel(level_timer);
+
+        // tt=0 makes WLED jump to where the fade should be, which ends its own fade
+        wled::Command command;
+        command.fields       = wled::Command::kBrightness | wled::Command::kTransition;
+        command.brightness   = level;
+        led_state.brightness = level;
+        pipeline_send(command);
+
+        DeviceDimmable::SetLevel(level);
+        return true;
+    }
+
+    uint16_t Capabilities() override { return Snapshot().capabilities; }
+
+    uint16_t Mireds() override
+    {
+        auto now   = std::chrono::steady_clock::now();
+        auto state = Snapshot();
+        if (state.mireds_transition.active(now))
+            return static_cast<uint16_t>(state.mireds_transition.value(now));
+        return state.mireds;
+    }
 
     void SetMireds(uint16_t aMireds) override
     {
+        cancel_transition(mireds_transition);
+        led_state.mireds = aMireds;
         set_cct(mireds_to_cct(aMireds));
         DeviceColorTemperature::SetMireds(aMireds);
     }
 
-    uint8_t Hue() override { return led_state.hsv.h; }
+    uint8_t Hue() override
+    {
+        auto now   = std::chrono::steady_clock::now();
+        auto state = Snapshot();
+        if (state.hue_transition.active(now))
+        {
+            int32_t value = state.hue_transition.value(now);
+            return static_cast<uint8_t>(((value % HUE_STEPS) + HUE_STEPS) % HUE_STEPS);
+        }
+        return state.hue;
+    }
+
     void SetHue(uint8_t aHue) override
     {
+        cancel_transition(hue_transition);
         set_hue(aHue);
         DeviceExtendedColor::SetHue(aHue);
     }
 
-    uint8_t Saturation() override { return led_state.hsv.s; }
+    uint8_t Saturation() override
+    {
+        auto now   = std::chrono::steady_clock::now();
+        auto state = Snapshot();
+        if (state.saturation_transition.active(now))
+            return static_cast<uint8_t>(state.saturation_transition.value(now));
+        return state.saturation;
+    }
+
     void SetSaturation(uint8_t aSaturation) override
     {
+        cancel_transition(saturation_transition);
         set_saturation(aSaturation);
         DeviceExtendedColor::SetSaturation(aSaturation);
     }
 
+    // Same values as Matter's MoveToHue direction
+    enum class HueDirection : uint8_t
+    {
+        kShortest = 0,
+        kLongest  = 1,
+        kUp       = 2,
+        kDown     = 3,
+    };
+
+    // MoveToHue, MoveToSaturation and MoveToHueAndSaturation with a transition time, in tenths of a second. WLED fades
+    // to the final color in one command while CurrentHue/CurrentSaturation are interpolated here. WLED blends in RGB,
+    // so the synthesized hue only approximates what the strip shows mid-fade.
+    void MoveToHue(uint8_t aHue, HueDirection aDirection, uint16_t aTransitionTime)
+    {
+        auto now      = std::chrono::steady_clock::now();
+        uint8_t from  = Hue();
+        int32_t delta = hue_delta(from, aHue, aDirection);
+        {
+            std::lock_guard lock(transition_mutex);
+            hue_transition.start(from, from + delta, std::chrono::milliseconds(aTransitionTime * 100), now);
+        }
+        led_state.hsv.h = aHue;
+        send_color_transition(aTransitionTime, now);
+    }
+
+    void MoveToSaturation(uint8_t aSaturation, uint16_t aTransitionTime)
+    {
+        auto now     = std::chrono::steady_clock::now();
+        uint8_t from = Saturation();
+        {
+            std::lock_guard lock(transition_mutex);
+            saturation_transition.start(from, aSaturation, std::chrono::milliseconds(aTransitionTime * 100), now);
+        }
+        led_state.hsv.s = aSaturation;
+        send_color_transition(aTransitionTime, now);
+    }
+
+    void MoveToHueAndSaturation(uint8_t aHue, uint8_t aSaturation, uint16_t aTransitionTime)
+    {
+        auto now      = std::chrono::steady_clock::now();
+        uint8_t hue   = Hue();
+        uint8_t sat   = Saturation();
+        int32_t delta = hue_delta(hue, aHue, HueDirection::kShortest);
+        auto duration = std::chrono::milliseconds(aTransitionTime * 100);
+        {
+            std::lock_guard lock(transition_mutex);
+            hue_transition.start(hue, hue + delta, duration, now);
+            saturation_transition.start(sat, aSaturation, duration, now);
+        }
+        led_state.hsv.h = aHue;
+        led_state.hsv.s = aSaturation;
+        send_color_transition(aTransitionTime, now);
+    }
+
+    // MoveToColorTemperature with a transition time, WLED fades cct natively
+    void MoveToMireds(uint16_t aMireds, uint16_t aTransitionTime)
+    {
+        aMireds       = std::clamp(aMireds, MIREDS_MIN, MIREDS_MAX);
+        auto now      = std::chrono::steady_clock::now();
+        uint16_t from = Mireds();
+        {
+            std::lock_guard lock(transition_mutex);
+            mireds_transition.start(from, aMireds, std::chrono::milliseconds(aTransitionTime * 100), now);
+        }
+
+        wled::Command command;
+        command.fields     = wled::Command::kCct | wled::Command::kTransition;
+        command.cct        = mireds_to_cct(aMireds);
+        command.transition = aTransitionTime;
+        led_state.cct      = command.cct;
+        led_state.mireds   = aMireds;
+        pipeline_send(command);
+
+        SetColorMode(static_cast<uint8_t>(chip::app::Clusters::ColorControl::ColorMode::kColorTemperature));
+        schedule_timer(color_timer, now + TRANSITION_REPORT_INTERVAL);
+    }
+
+    // StopMoveStep: freezes running color transitions where they are. Returns false if there were none.
+    bool StopColorTransitions()
+    {
+        auto now = std::chrono::steady_clock::now();
+        int32_t hue, saturation, mireds;
+        bool color, temperature;
+        {
+            std::lock_guard lock(transition_mutex);
+            color       = hue_transition.active(now) || saturation_transition.active(now);
+            temperature = mireds_transition.active(now);
+            if (!color && !temperature)
+                return false;
+            hue        = hue_transition.active(now) ? hue_transition.value(now) : led_state.hsv.h;
+            saturation = saturation_transition.active(now) ? saturation_transition.value(now) : led_state.hsv.s;
+            mireds     = mireds_transition.value(now);
+            hue_transition.stop();
+            saturation_transition.stop();
+            mireds_transition.stop();
+        }
+        gTimerWheel.cancel(color_timer);
+
+        // tt=0 makes WLED jump to where the fade should be, which ends its own fade
+        if (color)
+        {
+            led_state.hsv.h = static_cast<uint8_t>(((hue % HUE_STEPS) + HUE_STEPS) % HUE_STEPS);
+            led_state.hsv.s = static_cast<uint8_t>(saturation);
+
+            wled::Command command;
+            command.fields = wled::Command::kTransition;
+            stage_color(wled::ColorAccumulator::kHue | wled::ColorAccumulator::kSaturation, command, true);
+            DeviceExtendedColor::SetHue(led_state.hsv.h);
+            DeviceExtendedColor::SetSaturation(led_state.hsv.s);
+        }
+        if (temperature)
+        {
+            wled::Command command;
+            command.fields   = wled::Command::kCct | wled::Command::kTransition;
+            command.cct      = mireds_to_cct(static_cast<uint16_t>(mireds));
+            led_state.cct    = command.cct;
+            led_state.mireds = static_cast<uint16_t>(mireds);
+            pipeline_send(command);
+            DeviceColorTemperature::SetMireds(static_cast<uint16_t>(mireds));
+        }
+        return true;
+    }
+
 private:
     [[nodiscard]] uint8_t brightness() const noexcept { return led_state.brightness; }
 
+    uint16_t color_capabilities() const noexcept
+    {
+        int caps = 0;
+        // There doesn't seem to be a way in Matter to control a white channel
+        if (SUPPORTS_RGB(led_info.capabilities))
+        {
+            caps += static_cast<int>(chip::app::Clusters::ColorControl::ColorCapabilities::HueSaturationSupported);
+        }
+        if (SUPPORTS_COLOR_TEMPERATURE(led_info.capabilities))
+        {
+            caps += static_cast<int>(chip::app::Clusters::ColorControl::ColorCapabilities::ColorTemperatureSupported);
+        }
+        return static_cast<uint16_t>(caps);
+    }
+
+    // Called after every change to led_state or led_info, from whichever thread made it
+    void publish() noexcept
+    {
+        std::lock_guard lock(mutex);
+        publish_locked();
+    }
+
+    // Building and storing the snapshot under the mutex keeps parse_state() from reassigning led_info's strings while
+    // they are copied, and two publishers from storing out of order. Caller must hold the mutex.
+    void publish_locked() noexcept
+    {
+        wled::DeviceSnapshot next;
+        next.on           = led_state.on;
+        next.brightness   = led_state.brightness;
+        next.hue          = led_state.hsv.h;
+        next.saturation   = led_state.hsv.s;
+        next.mireds       = led_state.mireds;
+        next.capabilities = color_capabilities();
+        {
+            std::lock_guard lock(transition_mutex);
+            next.level_transition      = level_transition;
+            next.hue_transition        = hue_transition;
+            next.saturation_transition = saturation_transition;
+            next.mireds_transition     = mireds_transition;
+        }
+        snprintf(next.manufacturer, sizeof(next.manufacturer), "%s", led_info.manufacturer.c_str());
+        snprintf(next.serial_number, sizeof(next.serial_number), "%s", led_info.serial_number.c_str());
+        snprintf(next.model, sizeof(next.model), "%s", led_info.model.c_str());
+        snapshot.store(next);
+    }
+
     [[nodiscard]] bool on() const noexcept { return led_state.on; }
 
     void set_brightness(uint8_t brightness) noexcept
     {
         // Matter max level is 254, WLED is 255
         brightness = std::min(brightness, static_cast<uint8_t>(254));
-        Json::Value root;
-        root["bri"]          = brightness;
+        wled::Command command;
+        command.fields       = wled::Command::kBrightness;
+        command.brightness   = brightness;
         led_state.brightness = brightness;
-        pipeline_send(root);
+        pipeline_send(command);
     }
 
     void set_on(bool on) noexcept
     {
-        Json::Value root;
-        root["on"]   = on;
-        led_state.on = on;
-        pipeline_send(root);
+        wled::Command command;
+        command.fields = wled::Command::kOn;
+        command.on     = on;
+        led_state.on   = on;
+        pipeline_send(command);
     }
 
+    // Hue and saturation usually arrive as a pair, give the other half a moment to show up rather than flushing a
+    // color that is only half applied
     void set_hue(uint8_t hue) noexcept
     {
         led_state.hsv.h = hue;
-        led_state.hsv.v = led_state.brightness;
-        led_state.rgb   = HsvToRgb(led_state.hsv);
-        Json::Value root;
-        for (int i = 0; i < 3; i++)
-            root["seg"]["col"].append(Json::arrayValue);
-        root["seg"]["col"][0].insert(0, led_state.rgb.r);
-        root["seg"]["col"][0].insert(1, led_state.rgb.g);
-        root["seg"]["col"][0].insert(2, led_state.rgb.b);
-        if (SUPPORTS_WHITE_CHANNEL(led_info.capabilities))
-        {
-            root["seg"]["col"].append(Json::arrayValue);
-            root["seg"]["col"][0].insert(3, led_state.white);
-        }
-        pipeline_send(root);
+        stage_color(wled::ColorAccumulator::kHue);
     }
 
     void set_saturation(uint8_t saturation) noexcept
     {
         led_state.hsv.s = saturation;
-        led_state.hsv.v = led_state.brightness;
-        led_state.rgb   = HsvToRgb(led_state.hsv);
-        Json::Value root;
-        for (int i = 0; i < 3; i++)
-            root["seg"]["col"].append(Json::arrayValue);
-        root["seg"]["col"][0].insert(0, led_state.rgb.r);
-        root["seg"]["col"][0].insert(1, led_state.rgb.g);
-        root["seg"]["col"][0].insert(2, led_state.rgb.b);
-        if (SUPPORTS_WHITE_CHANNEL(led_info.capabilities))
+        stage_color(wled::ColorAccumulator::kSaturation);
+    }
+
+    // The color itself is only worked out by resolve_color(), `extra` (e.g. a transition) goes out along with it
+    void stage_color(uint8_t components, const wled::Command & extra = {}, bool leading = false) noexcept
+    {
         {
-            root["seg"]["col"].append(Json::arrayValue);
-            root["seg"]["col"][0].insert(3, led_state.white);
+            std::lock_guard guard(pipeline_mutex);
+            // The color values themselves are filled in by resolve_color() before anything goes out
+            wled::Command command = extra;
+            command.fields |= wled::Command::kColor;
+            merge_pending(command);
+            if (components & wled::ColorAccumulator::kHue)
+                color.set(wled::ColorAccumulator::kHue, led_state.hsv.h);
+            if (components & wled::ColorAccumulator::kSaturation)
+                color.set(wled::ColorAccumulator::kSaturation, led_state.hsv.s);
+            stamp_received();
         }
-        pipeline_send(root);
+
+        metrics.commands_submitted.add();
+        publish();
+        gCoalescer.submit(*this, leading);
+    }
+
+    // Folds staged color components into `pending`, pipeline_mutex must be held
+    void resolve_color() noexcept
+    {
+        if (!color.dirty())
+            return;
+
+        wled::ColorComponents current{ led_state.hsv.h, led_state.hsv.s, led_state.brightness, led_state.white };
+        color.resolve(current, SUPPORTS_WHITE_CHANNEL(led_info.capabilities), pending);
+        // The UDP notifier sends the whole state from here
+        led_state.rgb = { pending.color[0], pending.color[1], pending.color[2] };
     }
 
     void set_cct(uint8_t cct) noexcept
     {
-        Json::Value root;
-        root["seg"]["cct"] = cct;
-        led_state.cct      = cct;
-        pipeline_send(root);
+        wled::Command command;
+        command.fields = wled::Command::kCct;
+        command.cct    = cct;
+        led_state.cct  = cct;
+        pipeline_send(command);
     }
 
-    int connect()
+    // Splits "host", "host:port", "[v6]:port" or a bare IPv6 address into host and port
+    void parse_address(const std::string & address)
     {
-        curl = curl_easy_init();
-        if (!curl)
+        host = address;
+        port = DEFAULT_PORT;
+
+        size_t colon = address.rfind(':');
+        if (!address.empty() && address.front() == '[')
         {
-            std::cerr << "curl_easy_init: failed" << std::endl;
-            return -1;
+            size_t bracket = address.find(']');
+            host           = address.substr(1, bracket - 1);
+            if (bracket != std::string::npos && colon == bracket + 1)
+                port = static_cast<uint16_t>(std::stoi(address.substr(colon + 1)));
         }
-
-        curl_easy_setopt(curl, CURLOPT_URL, websocket_addr.c_str());
-        curl_easy_setopt(curl, CURLOPT_CONNECT_ONLY, 2L); /* websocket style */
-
-        CURLcode res = curl_easy_perform(curl);
-        if (res != CURLE_OK)
+        else if (colon != std::string::npos && address.find(':') == colon)
         {
-            std::cerr << "curl_easy_perform: " << curl_easy_strerror(res) << std::endl;
-            return -1;
+            host = address.substr(0, colon);
+            port = static_cast<uint16_t>(std::stoi(address.substr(colon + 1)));
         }
+    }
+
+    // Only starts the connection, the handshake is driven by update()/wait_for_state()
+    int connect()
+    {
+        std::lock_guard lock(mutex);
 
-        SetReachable(true);
+        if (ws.connect(host, port, "/ws"))
+            return -1;
 
+        connection_generation++;
+        info_valid      = false;
+        has_fingerprint = false;
+        inflight.clear();
         return 0;
     }
 
-    // Exponential backoff (max 5 minutes) until we can reconnect
-    void reconnect()
+    // Drives a fresh connection until the first state message arrives. Only used before the socket is handed to the
+    // monitor loop.
+    int wait_for_state()
     {
-        constexpr int FIVE_MINUTES = 5 * 60;
-        int sleep_seconds          = 5;
-
-        // When connecting to the websocket immediately on boot, it appears to connect fine but the first call to recv fails.
-        // Sleeping instead of immediately reconnecting seems to prevent this issue.
-        std::this_thread::sleep_for(std::chrono::seconds(sleep_seconds));
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(CONNECT_TIMEOUT_MS);
 
         while (true)
         {
-            if (!connect())
+            auto remaining =
+                std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+            if (remaining <= 0)
             {
-                ChipLogProgress(DeviceLayer, "[%s] Reconnected!", GetName());
-                wait();
-                recv();
-                // Alert the main thread to listen for this socket now
-                extern int wled_monitor_pipe[2];
-                char buf[1] = { 1 };
-                if (write(wled_monitor_pipe[1], buf, 1) < 1)
-                    ChipLogError(DeviceLayer, "Could not write!");
-                return;
+                ChipLogError(DeviceLayer, "[%s] Timed out waiting for websocket", GetName());
+                std::lock_guard lock(mutex);
+                ws.close();
+                return -1;
             }
 
-            sleep_seconds = std::min(sleep_seconds * 2, FIVE_MINUTES);
-            ChipLogError(DeviceLayer, "[%s] Could not reconnect, trying again in %d seconds...", GetName(), sleep_seconds);
-            std::this_thread::sleep_for(std::chrono::seconds(sleep_seconds));
+            struct pollfd pfd = { .fd = ws.fd(), .events = POLLIN, .revents = 0 };
+            if (ws.state() != wled::WebSocket::State::Open)
+                pfd.events |= POLLOUT;
+
+            int ret = poll(&pfd, 1, static_cast<int>(remaining));
+            if (ret < 0 && errno != EINTR)
+            {
+                std::cerr << "poll: " << strerror(errno) << std::endl;
+                abort();
+            }
+            if (ret <= 0)
+                continue;
+
+            uint32_t events = 0;
+            if (pfd.revents & POLLOUT)
+                events |= EPOLLOUT;
+            if (pfd.revents & (POLLIN | POLLHUP | POLLERR))
+                events |= EPOLLIN;
+
+            int result;
+            {
+                std::lock_guard lock(mutex);
+                result = read_state(events);
+            }
+            if (result < 0)
+                return -1;
+            if (result > 0)
+            {
+                SetReachable(true);
+                return 0;
+            }
         }
     }
 
-    void close()
+    // Driven by gReconnects, which owns the backoff
+    bool reconnect_attempt() override
     {
-        if (!curl)
-            return;
+        auto on_started = std::exchange(started, nullptr);
+        if (!on_started)
+            metrics.reconnect_attempts.add();
+
+        bool connected = !connect() && !wait_for_state();
+        if (connected)
+        {
+            // Alert the main thread to listen for this socket now
+            extern int wled_monitor_pipe[2];
+            char buf[1] = { 1 };
+            if (write(wled_monitor_pipe[1], buf, 1) < 1)
+                ChipLogError(DeviceLayer, "Could not write!");
+        }
 
-        curl_easy_cleanup(curl);
-        curl = nullptr;
+        if (on_started)
+            on_started(*this);
+        return connected;
     }
 
-    int recv(bool is_response = false) noexcept
+    const char * reconnect_name() override { return GetName(); }
+
+    void schedule_timer(wled::TimerWheel::Timer & timer, std::chrono::steady_clock::time_point when)
     {
-        char buffer[MAX_WEBSOCKET_BYTES]{};
-        size_t offset        = 0;
-        CURLcode result      = CURLE_OK;
-        long bytes_remaining = 0;
+        // The monitor loop may be sleeping past `when`
+        if (gTimerWheel.schedule(timer, when))
+            gReactor.wake();
+    }
 
-        while (!result)
+    bool transition_active(const wled::Transition & transition)
+    {
+        std::lock_guard lock(transition_mutex);
+        return transition.active(std::chrono::steady_clock::now());
+    }
+
+    // The color timer stops on its own once nothing is left running
+    void cancel_transition(wled::Transition & transition)
+    {
+        std::lock_guard lock(transition_mutex);
+        transition.stop();
+    }
+
+    void cancel_level_transition()
+    {
+        cancel_transition(level_transition);
+        gTimerWheel.cancel(level_timer);
+    }
+
+    // Signed number of hue steps from `from` to `to` in `direction`
+    static int32_t hue_delta(uint8_t from, uint8_t to, HueDirection direction)
+    {
+        int32_t up   = ((to - from) % HUE_STEPS + HUE_STEPS) % HUE_STEPS;
+        int32_t down = up == 0 ? 0 : up - HUE_STEPS;
+        switch (direction)
         {
-            size_t recv                       = 0;
-            const struct curl_ws_frame * meta = nullptr;
-            result                            = curl_ws_recv(curl, buffer + offset, sizeof(buffer) - offset, &recv, &meta);
-            offset += recv;
+        case HueDirection::kUp:
+            return up;
+        case HueDirection::kDown:
+            return down;
+        case HueDirection::kLongest:
+            return up > HUE_STEPS / 2 ? up : down;
+        case HueDirection::kShortest:
+        default:
+            return up <= HUE_STEPS / 2 ? up : down;
+        }
+    }
 
-            if (result == CURLE_OK)
-            {
-                if (meta->bytesleft == 0)
-                {
-                    break;
-                }
-                if (meta->bytesleft > (curl_off_t) (sizeof(buffer) - offset))
-                {
-                    ChipLogError(DeviceLayer, "Device buffer not large enough");
-                    abort();
-                }
-                bytes_remaining = meta->bytesleft;
-            }
-            else if (result == CURLE_AGAIN)
+    // One color command for the hue/saturation target already in led_state
+    void send_color_transition(uint16_t aTransitionTime, std::chrono::steady_clock::time_point now)
+    {
+        wled::Command command;
+        command.fields     = wled::Command::kTransition;
+        command.transition = aTransitionTime;
+        stage_color(wled::ColorAccumulator::kHue | wled::ColorAccumulator::kSaturation, command, true);
+
+        SetColorMode(static_cast<uint8_t>(chip::app::Clusters::ColorControl::ColorMode::kCurrentHueAndCurrentSaturation));
+        schedule_timer(color_timer, now + TRANSITION_REPORT_INTERVAL);
+    }
+
+    static void on_color_tick(void * context) { static_cast<WLED *>(context)->color_tick(); }
+
+    // Runs on the monitor thread while any color transition is in progress
+    void color_tick()
+    {
+        auto now    = std::chrono::steady_clock::now();
+        auto next   = now + TRANSITION_REPORT_INTERVAL;
+        bool active = false;
+        {
+            std::lock_guard lock(transition_mutex);
+            for (const wled::Transition * transition : { &hue_transition, &saturation_transition, &mireds_transition })
             {
-                if (bytes_remaining)
-                {
-                    ChipLogProgress(DeviceLayer, "Device not ready to send remaining data, sleeping 20ms...");
-                    std::this_thread::sleep_for(std::chrono::milliseconds(20));
-                    result = CURLE_OK;
-                }
-                else
-                {
-                    // Multithreaded programming is hard, we probably already read the intended message
-                    return 0;
-                }
+                if (!transition->active(now))
+                    continue;
+                active = true;
+                next   = std::min(next, transition->finish());
             }
-            else
-            {
-                if (result == CURLE_GOT_NOTHING)
-                {
-                    ChipLogProgress(DeviceLayer, "Got nothing from websocket, unexpectedly disconnected");
-                }
-                else if (meta && meta->flags & CURLWS_CLOSE)
-                {
-                    ChipLogProgress(DeviceLayer, "Websocket was closed");
-                }
-                else
-                {
-                    ChipLogError(DeviceLayer, "Unknown error: curl_ws_recv - %s", curl_easy_strerror(result));
-                }
-                SetReachable(false);
+        }
 
-                using namespace std::chrono_literals;
-                if (reconnect_future.valid() && reconnect_future.wait_for(0s) != std::future_status::ready)
-                    return -1;
+        // Only the ones that moved get reported
+        DeviceExtendedColor::SetHue(Hue());
+        DeviceExtendedColor::SetSaturation(Saturation());
+        DeviceColorTemperature::SetMireds(Mireds());
 
-                reconnect_future = std::async(std::launch::async, [=] { this->reconnect(); });
-                return -1;
-            }
+        if (active)
+            gTimerWheel.schedule(color_timer, next);
+    }
+
+    static void on_level_tick(void * context) { static_cast<WLED *>(context)->level_tick(); }
+
+    // Runs on the monitor thread while a level transition is in progress
+    void level_tick()
+    {
+        auto now = std::chrono::steady_clock::now();
+        bool active;
+        uint8_t level;
+        std::chrono::steady_clock::time_point finish;
+        {
+            std::lock_guard lock(transition_mutex);
+            active = level_transition.active(now);
+            level  = static_cast<uint8_t>(level_transition.value(now));
+            finish = level_transition.finish();
         }
 
-        if (is_response)
+        // Reports CurrentLevel and RemainingTime
+        DeviceDimmable::SetLevel(level);
+
+        if (active)
+            gTimerWheel.schedule(level_timer, std::min(now + TRANSITION_REPORT_INTERVAL, finish));
+    }
+
+    static void on_keepalive(void * context) { static_cast<WLED *>(context)->keepalive(); }
+
+    // Pings once the connection has been quiet for a third of the budget and gives up once it has been quiet for the
+    // whole budget. Runs on the monitor thread.
+    void keepalive()
+    {
+        auto now      = std::chrono::steady_clock::now();
+        auto interval = keepalive_budget / 3;
+        std::chrono::steady_clock::time_point deadline;
+        bool dead = false;
         {
-            return 0;
+            std::lock_guard lock(mutex);
+            if (!ws.is_open())
+                return;
+
+            auto idle = now - ws.last_activity();
+            deadline  = ws.last_activity() + keepalive_budget;
+            if (idle >= keepalive_budget)
+                dead = true;
+            else if (idle >= interval && ws.send_ping() < 0)
+                dead = true;
+            if (dead)
+                ws.close();
         }
 
-        Json::Value root;
-        if (reader.parse(buffer, root) == false)
+        if (dead)
         {
-            std::cerr << "reader.parse: failed to parse" << std::endl;
-            abort();
-            return -1;
+            ChipLogError(DeviceLayer, "[%s] No answer for %lld ms, assuming it is gone", GetName(),
+                         static_cast<long long>(keepalive_budget.count()));
+            disconnected();
+            // Have the monitor loop drop the closed socket now rather than on its next unrelated event
+            extern int wled_monitor_pipe[2];
+            char buf[1] = { 1 };
+            if (write(wled_monitor_pipe[1], buf, 1) < 1)
+                ChipLogError(DeviceLayer, "Could not write!");
+            return;
         }
 
-        led_state.on = root["state"]["on"].asBool();
-        // Matter max level is 254, WLED is 255
-        led_state.brightness = static_cast<uint8_t>(root["state"]["bri"].asUInt());
-        led_state.brightness = std::min(led_state.brightness, static_cast<uint8_t>(254));
+        keepalive_wheel->schedule(keepalive_timer, std::min(now + interval, deadline));
+    }
 
-        led_info.capabilities  = root["info"]["leds"]["lc"].asInt();
-        led_info.name          = root["info"]["name"].asString();
-        led_info.serial_number = root["info"]["mac"].asString();
-        led_info.model         = root["info"]["arch"].asString() + " v" + root["info"]["ver"].asString();
+    void close()
+    {
+        std::lock_guard lock(mutex);
+        ws.close();
+    }
 
-        if (strncmp(mName, led_info.name.c_str(), sizeof(mName)) != 0)
+    // Returns -1 on disconnect, 0 if nothing new arrived and 1 if led_state/led_info were updated
+    int recv(uint32_t events = EPOLLIN) noexcept
+    {
+        int result;
         {
-            SetName(led_info.name.c_str());
+            std::lock_guard lock(mutex);
+            result = read_state(events);
         }
 
-        // std::cout << "RGB Support: " << SUPPORTS_RGB(led_state.capabilities) << std::endl;
-        // std::cout << "White Support: " << SUPPORTS_WHITE_CHANNEL(led_state.capabilities) << std::endl;
-        // std::cout << "Color temp Support: " << SUPPORTS_COLOR_TEMPERATURE(led_state.capabilities) << std::endl;
+        if (result < 0)
+            disconnected();
+        return result;
+    }
 
-        auto segment = root["state"]["seg"][0];
-        auto primary = segment["col"][0];
+    // Caller must hold the mutex
+    int read_state(uint32_t events) noexcept
+    {
+        int updated = 0;
 
-        if (SUPPORTS_RGB(led_info.capabilities))
+        if ((events & EPOLLOUT) && ws.on_writable() < 0)
+            return -1;
+
+        if (!(events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)))
+            return 0;
+
+        int ret;
+        do
+        {
+            ret = ws.on_readable();
+            if (ret < 0)
+                return -1;
+
+            // Only the newest state matters, anything older is superseded
+            std::string_view message;
+            std::string_view latest;
+            while (ws.next_message(message))
+                latest = message;
+
+            if (!latest.empty() && !is_duplicate(latest) && parse_state(latest))
+                updated = 1;
+        } while (ret == 1);
+
+        // A close frame shuts the socket down without a read error
+        if (ws.state() == wled::WebSocket::State::Closed)
+            return -1;
+
+        return updated;
+    }
+
+    void disconnected() noexcept
+    {
+        ChipLogProgress(DeviceLayer, "[%s] Websocket disconnected", GetName());
+        SetReachable(false);
+        gReconnects.schedule(*this);
+    }
+
+    // WLED pushes the whole document on every change and usually more than once per change. Remember a fingerprint of
+    // the last state object so byte-identical repeats skip parsing and the setters entirely. Caller must hold the mutex.
+    bool is_duplicate(std::string_view message) noexcept
+    {
+        std::string_view state;
+        if (!info_valid || !wled::StateParser::find_member(message, "state", state))
+            return false;
+
+        uint64_t fingerprint = wled::fingerprint(state);
+        if (has_fingerprint && fingerprint == state_fingerprint)
+            return true;
+
+        state_fingerprint = fingerprint;
+        has_fingerprint   = true;
+        return false;
+    }
+
+    // Returns true if the message was a state document and led_state/led_info were updated from it
+    bool parse_state(std::string_view message) noexcept
+    {
+        wled::ParsedState parsed;
+        auto parse_start = std::chrono::steady_clock::now();
+        bool parsed_ok   = wled::StateParser::parse(message, !info_valid, parsed);
+        auto parse_end   = std::chrono::steady_clock::now();
+        metrics.parse_time.record(parse_end - parse_start);
+        if (!parsed_ok)
         {
-            led_state.rgb.r = static_cast<uint8_t>(primary[0].asInt());
-            led_state.rgb.g = static_cast<uint8_t>(primary[1].asInt());
-            led_state.rgb.b = static_cast<uint8_t>(primary[2].asInt());
-            led_state.hsv   = RgbToHsv(led_state.rgb);
+            ChipLogError(DeviceLayer, "[%s] Could not parse websocket message", GetName());
+            return false;
         }
 
-        if (SUPPORTS_WHITE_CHANNEL(led_info.capabilities))
-            led_state.white = static_cast<uint8_t>(primary[3].asInt());
+        if (!inflight.empty())
+        {
+            metrics.commands_unconfirmed.add(inflight.expire(parse_end, std::chrono::milliseconds(ACK_TIMEOUT_MS)));
+            wled::Expectation matched;
+            if (inflight.acknowledge(parsed, &matched))
+                record_confirmed(matched, parse_end);
+
+            // Anything still in flight is newer than this push, keep the optimistic values for those fields
+            uint8_t owed = inflight.pending_fields();
+            if (owed & wled::Expectation::kOn)
+                parsed.present &= ~wled::ParsedState::kOn;
+            if (owed & wled::Expectation::kBrightness)
+                parsed.present &= ~wled::ParsedState::kBrightness;
+            if (owed & wled::Expectation::kColor)
+                parsed.present &= ~wled::ParsedState::kColor;
+            if (owed & wled::Expectation::kCct)
+                parsed.present &= ~wled::ParsedState::kCct;
+
+            // This push wasn't applied in full, a repeat of it must not be skipped as a duplicate. It may be the one
+            // that confirms or expires what is still owed.
+            if (owed != 0)
+                has_fingerprint = false;
+        }
 
-        if (SUPPORTS_COLOR_TEMPERATURE(led_info.capabilities))
+        if (parsed.has(wled::ParsedState::kOn))
+            led_state.on = parsed.on;
+        if (parsed.has(wled::ParsedState::kTransition))
+            led_state.transition = parsed.transition;
+        // Matter max level is 254, WLED is 255
+        if (parsed.has(wled::ParsedState::kBrightness))
+            led_state.brightness = std::min(parsed.brightness, static_cast<uint8_t>(254));
+
+        if (!info_valid && parsed.has(wled::ParsedState::kCapabilities))
+        {
+            // info only changes across reconnects, so it is only parsed on the first push of a connection
+            info_valid             = true;
+            led_info.capabilities  = parsed.capabilities;
+            led_info.name          = parsed.name;
+            led_info.serial_number = parsed.mac;
+            led_info.model         = std::string(parsed.arch) + " v" + parsed.version;
+
+            if (strncmp(mName, led_info.name.c_str(), sizeof(mName)) != 0)
+            {
+                SetName(led_info.name.c_str());
+            }
+        }
+
+        if (parsed.has(wled::ParsedState::kColor))
+        {
+            if (SUPPORTS_RGB(led_info.capabilities) && parsed.color_count >= 3)
+            {
+                // The echo of our own write. Keep the exact hue/saturation Matter asked for, the RGB round trip would
+                // come back slightly off and be reported to every subscriber a second time.
+                RgbColor rgb = { parsed.color[0], parsed.color[1], parsed.color[2] };
+                if (rgb.r != led_state.rgb.r || rgb.g != led_state.rgb.g || rgb.b != led_state.rgb.b)
+                {
+                    led_state.rgb = rgb;
+                    led_state.hsv = RgbToHsv(rgb);
+                }
+            }
+
+            if (SUPPORTS_WHITE_CHANNEL(led_info.capabilities) && parsed.color_count >= 4)
+                led_state.white = parsed.color[3];
+        }
+
+        if (SUPPORTS_COLOR_TEMPERATURE(led_info.capabilities) && parsed.has(wled::ParsedState::kCct))
         {
-            uint16_t cct = static_cast<uint16_t>(segment["cct"].asUInt());
+            uint16_t cct = parsed.cct;
             if (cct >= 1900 && cct <= 10091) // Kelvin instead of relative, need to convert
             {
                 // TODO: Does this ever actually happen?
                 cct = static_cast<uint16_t>(255 * (cct - 1900) / (10091 - 1900));
             }
-            // cct is appropriately sized now
-            led_state.cct = static_cast<uint8_t>(cct);
+            // cct is appropriately sized now. Same as the color, an echo keeps the mireds Matter asked for.
+            if (cct != led_state.cct || led_state.mireds == 0)
+            {
+                led_state.cct    = static_cast<uint8_t>(cct);
+                led_state.mireds = cct_to_mireds(led_state.cct);
+            }
         }
 
-        return 0;
+        publish_locked();
+        return true;
     }
 
-    // TODO: Probably rename to send_and_recv or create a separate function
-    int send(std::string data) noexcept
+    // Fire-and-forget. The command's fields are what the device's answer should look like, so it can be told apart from
+    // external changes when it arrives.
+    int send(const wled::Command & command) noexcept
     {
-        std::lock_guard lock(mutex);
+        // Small enough for the stack, and identify may be sending from another thread
+        wled::CommandEncoder::Buffer frame;
+        size_t length = wled::CommandEncoder::encode(command, frame);
 
-        size_t sent;
-        CURLcode result = curl_ws_send(curl, data.c_str(), strlen(data.c_str()), &sent, 0, CURLWS_TEXT);
-        if (result != CURLE_OK)
-        {
-            std::cerr << "curl_ws_send: " << curl_easy_strerror(result) << std::endl;
-            abort();
-        }
-        data.erase(data.length() - 1); // Strip extraneous new line for logging
-        ChipLogProgress(DeviceLayer, ">>>>>>>>>>>>>>>>>>>>> %s", data.c_str());
+        int result = transmit(frame, length, command.expectation());
+        if (result < 0)
+            return result;
 
-        // TODO: I think there is a race condition here if an update comes before the response is received e.g.
-        // -> we send message
-        // <- we receive an external update (that we are now erroneously ignoring)
-        // <- we receive the websocket ack message from the sent message (we are now erroenously setting that)
-        recv(true);
+        wled::trace::record(wled::trace::Event::kSend, static_cast<uint32_t>(GetEndpointId() | command.transition << 16),
+                            wled::trace::pack_command(command.fields, command.on, command.brightness, command.color, command.cct),
+                            "ws");
 
-        return (int) result;
+        return result;
     }
 
-    void update_json(Json::Value & a)
+    int transmit(const char * data, size_t length, wled::Expectation expectation) noexcept
     {
-        for (const auto & key : a.getMemberNames())
+        int result;
         {
-            // Only top-level keys!
-            if (key == "cct" || key == "col")
-                continue;
-
-            if (a[key].type() == Json::objectValue && pipeline_data[key].type() == Json::objectValue)
+            std::lock_guard lock(mutex);
+            if (!ws.is_open())
             {
-                update_json(a[key]);
+                // Either already handed off to gReconnects or still connecting
+                ChipLogError(DeviceLayer, "[%s] Not connected, dropping command", GetName());
+                return -1;
             }
-            else
+            auto start = std::chrono::steady_clock::now();
+            result     = ws.send_text(data, length);
+            metrics.send_latency.record(std::chrono::steady_clock::now() - start);
+            // led_state was changed optimistically, the device's answer must be applied even if it matches the last push
+            has_fingerprint = false;
+
+            if (result >= 0)
+                metrics.commands_sent.add();
+            if (result >= 0 && expectation.fields)
             {
-                pipeline_data[key] = a[key];
+                expectation.sent = std::chrono::steady_clock::now();
+                inflight.push(expectation);
             }
         }
+        if (result < 0)
+        {
+            ChipLogError(DeviceLayer, "[%s] Could not send to websocket", GetName());
+            // The monitor loop won't hear about a socket that's already closed, so kick off the reconnect here
+            disconnected();
+        }
+        return result;
+    }
+
+    // The first write into an empty `pending` starts its clock, pipeline_mutex must be held
+    void stamp_received() noexcept
+    {
+        if (pending.received == std::chrono::steady_clock::time_point{})
+            pending.received = wled::ReceivedScope::current();
     }
 
-    void pipeline_send(Json::Value root) noexcept
+    // Splits a confirmed command's trip into its stages. Commands sent around the coalescer (identify, room actions)
+    // only have the device leg.
+    void record_confirmed(const wled::Expectation & command, std::chrono::steady_clock::time_point confirmed) noexcept
+    {
+        using wled::CommandStage;
+        constexpr std::chrono::steady_clock::time_point unset{};
+
+        auto device = confirmed - command.sent;
+        metrics.stage(CommandStage::kDevice).record(device);
+        if (command.received == unset || command.flushed == unset)
+            return;
+
+        auto coalesce = command.flushed - command.received;
+        auto send     = command.sent - command.flushed;
+        metrics.stage(CommandStage::kCoalesce).record(coalesce);
+        metrics.stage(CommandStage::kSend).record(send);
+        metrics.stage(CommandStage::kTotal).record(confirmed - command.received);
+
+        auto micros = [](std::chrono::steady_clock::duration d) {
+            auto us = std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+            return static_cast<uint64_t>(us < 0 ? 0 : us);
+        };
+        wled::trace::record(wled::trace::Event::kCommandConfirmed, GetEndpointId(),
+                            wled::trace::pack_stages(micros(coalesce), micros(send), micros(device)));
+    }
+
+    void pipeline_send(const wled::Command & command) noexcept
     {
         {
             std::lock_guard guard(pipeline_mutex);
-            update_json(root);
+            merge_pending(command);
+            stamp_received();
         }
 
-        using namespace std::chrono_literals;
-        if (pipeline_future.valid() && pipeline_future.wait_for(0s) != std::future_status::ready)
+        metrics.commands_submitted.add();
+        publish();
+        gCoalescer.submit(*this);
+    }
+
+    // Folds `command` into `pending`. If the two need different transitions what is pending goes out right away rather
+    // than fading (or not fading) with the newer command's `tt`. pipeline_mutex must be held.
+    void merge_pending(const wled::Command & command) noexcept
+    {
+        wled::Command staged = pending;
+        if (color.dirty())
+            staged.fields |= wled::Command::kColor;
+        if (staged.conflicts(command))
+        {
+            resolve_color();
+            send_pending();
+        }
+        pending.merge(command);
+    }
+
+    void flush() override
+    {
+        std::lock_guard guard(pipeline_mutex);
+        resolve_color();
+        if (pending.empty())
             return;
 
-        pipeline_future = std::async(std::launch::async, [&] {
-            std::this_thread::sleep_for(0.05s);
-            {
-                std::lock_guard guard(pipeline_mutex);
+        // Keep collapsing into `pending` until the light has caught up, rather than queueing stale values behind it
+        if (congested())
+        {
+            held_back = true;
+            // Retry after another window in case neither an ack nor a drained socket shows up
+            gCoalescer.submit(*this);
+            return;
+        }
 
-                // On start up, Matter will send only a 'level' command but not an 'on' command
-                Json::Value root2;
-                root2["on"] = IsOn();
-                update_json(root2);
+        send_pending();
+    }
 
-                send(writer.write(pipeline_data));
-                pipeline_data = Json::Value();
-            }
-        });
+    // pipeline_mutex must be held and the color resolved
+    void send_pending() noexcept
+    {
+        // On start up, Matter will send only a 'level' command but not an 'on' command
+        pending.fields |= wled::Command::kOn;
+        pending.on      = IsOn();
+        pending.flushed = std::chrono::steady_clock::now();
+
+        if (!udp.is_open() || !udp_capable(pending) || transmit_udp(pending.expectation()) < 0)
+            send(pending);
+        pending = {};
+    }
+
+    // Too much already on its way to the light: bytes stuck in the socket or commands it hasn't answered yet
+    bool congested() noexcept
+    {
+        std::lock_guard lock(mutex);
+        if (!ws.is_open())
+            return false;
+        // A command whose answer didn't match (e.g. a clamped value) must not throttle writes for the whole ACK_TIMEOUT_MS
+        auto since = std::chrono::steady_clock::now() - std::chrono::milliseconds(OUTSTANDING_TIMEOUT_MS);
+        return ws.unsent() > 0 || inflight.sent_since(since) >= MAX_OUTSTANDING;
     }
 
-    int wait() const noexcept
+    // The notifier packet only has room for on/off, brightness and the primary color
+    static bool udp_capable(const wled::Command & command) noexcept
     {
-        fd_set rfds;
-        FD_ZERO(&rfds);
-        FD_SET(socket(), &rfds);
-        int ret = select(socket() + 1, &rfds, NULL, NULL, 0);
-        if (ret == -1)
+        return (command.fields & ~(wled::Command::kOn | wled::Command::kBrightness | wled::Command::kColor)) == 0;
+    }
+
+    int transmit_udp(wled::Expectation expectation) noexcept
+    {
+        std::lock_guard lock(mutex);
+
+        // Every datagram carries the full state, WLED has no notion of a partial update here
+        uint8_t color[4]   = { led_state.rgb.r, led_state.rgb.g, led_state.rgb.b, led_state.white };
+        uint8_t brightness = led_state.on ? led_state.brightness : 0;
+        auto transition    = static_cast<uint16_t>(std::min(led_state.transition * 100, UINT16_MAX));
+        auto start = std::chrono::steady_clock::now();
+        if (udp.send_state(brightness, color, transition) < 0)
         {
-            std::cerr << "select: " << strerror(errno) << std::endl;
-            abort();
+            ChipLogError(DeviceLayer, "[%s] Could not send UDP sync, falling back to websocket", GetName());
+            return -1;
         }
-        return ret;
+        metrics.send_latency.record(std::chrono::steady_clock::now() - start);
+        metrics.commands_sent.add();
+
+        // The resulting state still arrives over the websocket
+        has_fingerprint = false;
+        if (expectation.fields)
+        {
+            expectation.sent = std::chrono::steady_clock::now();
+            inflight.push(expectation);
+        }
+        wled::trace::record(wled::trace::Event::kSend, static_cast<uint32_t>(GetEndpointId() | led_state.transition << 16),
+                            wled::trace::pack_command(wled::Command::kOn | wled::Command::kBrightness | wled::Command::kColor,
+                                                      led_state.on, brightness, color, 0),
+                            "udp");
+        return 0;
     }
 
     inline uint8_t mireds_to_cct(uint16_t aMireds)
@@ -553,6 +1278,10 @@ private:
         RgbColor rgb;
         HsvColor hsv;
         uint8_t white;
+        // What Matter last asked for, cct doesn't round trip exactly
+        uint16_t mireds = 0;
+        // In 100ms units, same as WLED's default of 700ms until the first push says otherwise
+        uint16_t transition = 7;
     };
 
     struct led_info
@@ -565,19 +1294,69 @@ private:
     };
 
     std::mutex mutex;
-    std::string websocket_addr;
-    CURL * curl;
+    wled::WebSocket ws{ MAX_WEBSOCKET_BYTES };
+    std::string host;
+    uint16_t port                  = DEFAULT_PORT;
+    uint32_t connection_generation = 0;
     led_state led_state;
     led_info led_info;
-    std::future<void> reconnect_future;
     std::string ip;
+    // Set by StartAsync() until the first attempt has run
+    std::function<void(WLED &)> started;
 
-    std::future<void> pipeline_future;
-    Json::Value pipeline_data;
+    // Waiting for the coalescer, guarded by pipeline_mutex
+    wled::Command pending;
+    // Hue/saturation not yet folded into `pending`, also guarded by pipeline_mutex
+    wled::ColorAccumulator color;
     std::mutex pipeline_mutex;
-
-    Json::Reader reader;
-    Json::FastWriter writer;
+    // `pending` is waiting for the light to catch up, see congested()
+    std::atomic<bool> held_back{ false };
+    // Opened by EnableUdpSync(), hot attributes go out as WLED notifier packets instead of JSON
+    wled::UdpSync udp;
+
+    // Whether led_info has been filled in on the current connection
+    bool info_valid = false;
+    // Fingerprint of the last state object that was applied
+    uint64_t state_fingerprint = 0;
+    bool has_fingerprint       = false;
+    // Commands sent but not yet reflected in a push
+    wled::InflightCommands inflight;
+
+    wled::TimerWheel::Timer keepalive_timer{ on_keepalive, this };
+
+    // Guards the transitions, they are started from the CHIP thread and followed on the monitor thread
+    std::mutex transition_mutex;
+    wled::Transition level_transition;
+    wled::TimerWheel::Timer level_timer{ on_level_tick, this };
+    wled::Transition hue_transition;
+    wled::Transition saturation_transition;
+    wled::Transition mireds_transition;
+    wled::TimerWheel::Timer color_timer{ on_color_tick, this };
+
+    // Published copy of the above for readers on other threads, see Snapshot()
+    wled::Seqlock<wled::DeviceSnapshot> snapshot;
+    // Registered with gMetrics for as long as the light exists
+    wled::DeviceMetrics metrics;
+    wled::TimerWheel * keepalive_wheel = nullptr;
+    std::chrono::milliseconds keepalive_budget{ 0 };
 
     static constexpr int MAX_WEBSOCKET_BYTES = 24576;
+    static constexpr uint16_t DEFAULT_PORT   = 80;
+    static constexpr int CONNECT_TIMEOUT_MS  = 10000;
+
+    // How long a command may go unconfirmed before its fields are taken from pushes again
+    static constexpr int ACK_TIMEOUT_MS = 2000;
+    // Unanswered commands before further writes are held back and collapsed
+    static constexpr size_t MAX_OUTSTANDING     = 2;
+    static constexpr int OUTSTANDING_TIMEOUT_MS = 500;
+
+    // Matter only wants transitioning attributes reported about once a second
+    static constexpr std::chrono::milliseconds TRANSITION_REPORT_INTERVAL{ 1000 };
+
+    // Matter hue goes from 0 to 254 and wraps
+    static constexpr int32_t HUE_STEPS = 255;
+
+    // Matter's color temperature limits for WLED's 1900K to 10091K
+    static constexpr uint16_t MIREDS_MIN = 100;
+    static constexpr uint16_t MIREDS_MAX = 526;
 };
@@ -0,0 +1,84 @@
+#include "inflight.hpp"
+
+using namespace wled;
+
+bool Expectation::matches(const ParsedState & state) const
+{
+    if ((fields & kOn) && (!state.has(ParsedState::kOn) || state.on != on))
+        return false;
+
+    // WLED is 0-255, the bridge clamps to Matter's 254 before sending so compare as sent
+    if ((fields & kBrightness) && (!state.has(ParsedState::kBrightness) || state.brightness != brightness))
+        return false;
+
+    if (fields & kColor)
+    {
+        if (!state.has(ParsedState::kColor) || state.color_count < 3)
+            return false;
+        for (size_t i = 0; i < 3; i++)
+            if (state.color[i] != color[i])
+                return false;
+    }
+
+    if ((fields & kCct) && (!state.has(ParsedState::kCct) || state.cct != cct))
+        return false;
+
+    return true;
+}
+
+void InflightCommands::push(const Expectation & expectation)
+{
+    if (count == kMaxInflight)
+    {
+        head = (head + 1) % kMaxInflight;
+        count--;
+    }
+    ring[(head + count) % kMaxInflight] = expectation;
+    count++;
+}
+
+size_t InflightCommands::acknowledge(const ParsedState & state, Expectation * matched)
+{
+    // Newest first, confirming a command implies everything before it was applied too
+    for (size_t i = count; i > 0; i--)
+    {
+        if (at(i - 1).matches(state))
+        {
+            if (matched)
+                *matched = at(i - 1);
+            head = (head + i) % kMaxInflight;
+            count -= i;
+            return i;
+        }
+    }
+    return 0;
+}
+
+size_t InflightCommands::expire(std::chrono::steady_clock::time_point now, std::chrono::milliseconds timeout)
+{
+    size_t expired = 0;
+    while (count > 0 && now - at(0).sent > timeout)
+    {
+        head = (head + 1) % kMaxInflight;
+        count--;
+        expired++;
+    }
+    return expired;
+}
+
+size_t InflightCommands::sent_since(std::chrono::steady_clock::time_point since) const
+{
+    // Oldest first, so everything after the first match is newer too
+    for (size_t i = 0; i < count; i++)
+        if (at(i).sent > since)
+            return count - i;
+    return 0;
+}
+
+uint8_t InflightCommands::pending_fields() const
+{
+    uint8_t fields = 0;
+    for (size_t i = 0; i < count; i++)
+        fields = static_cast<uint8_t>(fields | at(i).fields);
+    return fields;
+}
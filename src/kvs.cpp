@@ -80,7 +80,8 @@ std::vector<std::tuple<uint8_t, WLED *>> KVS::get_wleds()
                 continue;
             }
 
-            wleds.push_back({ i, new WLED(inst.ip, inst.location) });
+            // Connecting is left to the caller so all stored lights can come up at once
+            wleds.push_back({ i, new WLED(inst.ip, inst.location, false) });
         }
     }
 
@@ -0,0 +1,73 @@
+#include "level-control.hpp"
+
+#include <app-common/zap-generated/cluster-objects.h>
+#include <app/data-model/Decode.h>
+#include <lib/core/TLVReader.h>
+
+#include "wled.h"
+
+using namespace wled;
+using namespace chip::app::Clusters::LevelControl;
+
+LevelControlHandler::LevelControlHandler(Lookup lookup) :
+    CommandHandlerInterface(chip::NullOptional, chip::app::Clusters::LevelControl::Id), lookup(lookup)
+{}
+
+void LevelControlHandler::InvokeCommand(HandlerContext & ctx)
+{
+    switch (ctx.mRequestPath.mCommandId)
+    {
+    case Commands::MoveToLevel::Id:
+        move_to_level<Commands::MoveToLevel::DecodableType>(ctx, false);
+        break;
+    case Commands::MoveToLevelWithOnOff::Id:
+        move_to_level<Commands::MoveToLevelWithOnOff::DecodableType>(ctx, true);
+        break;
+    case Commands::Stop::Id:
+    case Commands::StopWithOnOff::Id:
+        stop(ctx);
+        break;
+    default:
+        break;
+    }
+}
+
+template <typename Request>
+void LevelControlHandler::move_to_level(HandlerContext & ctx, bool with_on_off)
+{
+    WLED * light = lookup(ctx.mRequestPath.mEndpointId);
+    if (light == nullptr || !light->IsReachable())
+        return;
+
+    // Decode a copy, the server reads the payload again if the command is left to it
+    chip::TLV::TLVReader reader(ctx.mPayload);
+    Request request;
+    if (chip::app::DataModel::Decode(reader, request) != CHIP_NO_ERROR)
+        return;
+
+    // A null transition time means the OnOffTransitionTime attribute, which the server resolves
+    if (request.transitionTime.IsNull() || request.transitionTime.Value() == 0)
+        return;
+
+    // Without OnOff a light that is off only moves if its options say so, the server decides that
+    if (!with_on_off && !light->IsOn())
+        return;
+
+    ChipLogProgress(DeviceLayer, "[%s] MoveToLevel %d over %dms", light->GetName(), request.level,
+                    request.transitionTime.Value() * 100);
+    light->MoveToLevel(request.level, request.transitionTime.Value(), with_on_off);
+
+    ctx.mCommandHandler.AddStatus(ctx.mRequestPath, chip::Protocols::InteractionModel::Status::Success);
+    ctx.SetCommandHandled();
+}
+
+void LevelControlHandler::stop(HandlerContext & ctx)
+{
+    // Only transitions this handler started, the server stops its own
+    WLED * light = lookup(ctx.mRequestPath.mEndpointId);
+    if (light == nullptr || !light->StopLevelTransition())
+        return;
+
+    ctx.mCommandHandler.AddStatus(ctx.mRequestPath, chip::Protocols::InteractionModel::Status::Success);
+    ctx.SetCommandHandled();
+}
@@ -24,6 +24,7 @@
 #include <app-common/zap-generated/callback.h>
 #include <app-common/zap-generated/ids/Attributes.h>
 #include <app-common/zap-generated/ids/Clusters.h>
+#include <app/CommandHandlerInterfaceRegistry.h>
 #include <app/ConcreteAttributePath.h>
 #include <app/EventLogging.h>
 #include <app/reporting/reporting.h>
@@ -52,16 +53,33 @@
 #include <app/server/Server.h>
 
 #include <array>
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <cstdint>
 #include <cstring>
+#include <deque>
 #include <iostream>
+#include <algorithm>
 #include <math.h>
+#include <mutex>
 #include <sys/select.h>
+#include <thread>
+#include <tuple>
 #include <vector>
 
 #include "kvs.hpp"
+#include "level-control.hpp"
 #include "mdns.hpp"
+#include "metrics-exporter.hpp"
+#include "monitor.hpp"
+#include "coalescer.hpp"
+#include "color-control.hpp"
+#include "reactor.hpp"
+#include "reconnect.hpp"
+#include "spsc-ring.hpp"
+#include "timer-wheel.hpp"
+#include "trace.hpp"
 #include "wled.h"
 
 using namespace chip;
@@ -124,42 +142,65 @@ Device * gDevices[CHIP_DEVICE_CONFIG_DYNAMIC_ENDPOINT_COUNT]{};
 //   - Descriptor
 //   - Bridged Device Basic Information
 
+// Attributes served by the light itself. Each list expands into both the DECLARE_DYNAMIC_ATTRIBUTE list the endpoint is
+// built from and the dispatch table behind emberAfExternalAttributeRead/WriteCallback, so the two can't drift apart.
+// Columns are X(cluster, attribute, type, size, mask, reader, writer), a null writer rejects writes. ClusterRevision
+// comes from DECLARE_DYNAMIC_ATTRIBUTE_LIST_END and is added to the dispatch table separately.
+#define IDENTIFY_ATTRIBUTES(X)                                                                                                     \
+    X(Identify, IdentifyTime, INT16U, 2, ZAP_ATTRIBUTE_MASK(WRITABLE), ReadIdentifyTime, WriteIdentifyTime)                     \
+    X(Identify, IdentifyType, BITMAP8, 1, 0, ReadIdentifyType, nullptr)
+
+#define ON_OFF_ATTRIBUTES(X) X(OnOff, OnOff, BOOLEAN, 1, 0, ReadOnOff, WriteOnOff)
+
+// TODO: Spec says OnLevel (INT8U, WRITABLE | NULLABLE) is mandatory but it doesn't seem to be?
+#define LEVEL_CONTROL_ATTRIBUTES(X)                                                                                                \
+    X(LevelControl, CurrentLevel, INT8U, 1, ZAP_ATTRIBUTE_MASK(NULLABLE), ReadCurrentLevel, WriteCurrentLevel)                  \
+    X(LevelControl, RemainingTime, INT16U, 2, 0, ReadRemainingTime, WriteIgnored)                                               \
+    X(LevelControl, MinLevel, INT8U, 1, 0, ReadUint8<0>, nullptr)                                                               \
+    X(LevelControl, Options, BITMAP8, 1, ZAP_ATTRIBUTE_MASK(WRITABLE), ReadUint8<ZCL_LEVEL_CONTROL_OPTIONS>, nullptr)            \
+    X(LevelControl, StartUpCurrentLevel, INT8U, 1, ZAP_ATTRIBUTE_MASK(WRITABLE), ReadCurrentLevel, nullptr)                     \
+    X(LevelControl, FeatureMap, BITMAP32, 4, 0, ReadUint32<ZCL_LEVEL_CONTROL_FEATURE_MAP>, nullptr)
+
+#define COLOR_CONTROL_ATTRIBUTES(X)                                                                                                \
+    X(ColorControl, CurrentHue, INT8U, 1, 0, ReadHue, WriteHue)                                                                 \
+    X(ColorControl, CurrentSaturation, INT8U, 1, 0, ReadSaturation, WriteSaturation)                                            \
+    X(ColorControl, ColorTemperatureMireds, INT16U, 2, 0, ReadMireds, WriteMireds)                                              \
+    X(ColorControl, ColorMode, ENUM8, 1, 0, ReadColorMode, WriteColorMode)                                                      \
+    X(ColorControl, Options, BITMAP8, 1, ZAP_ATTRIBUTE_MASK(WRITABLE), ReadUint8<ZCL_COLOR_CONTROL_OPTIONS>, nullptr)            \
+    X(ColorControl, EnhancedColorMode, ENUM8, 1, 0, ReadColorMode, WriteColorMode)                                              \
+    X(ColorControl, ColorCapabilities, BITMAP16, 2, 0, ReadColorCapabilities, nullptr)                                          \
+    X(ColorControl, ColorTempPhysicalMinMireds, INT16U, 2, 0, ReadUint16<kPhysicalMinMireds>, nullptr)                          \
+    X(ColorControl, ColorTempPhysicalMaxMireds, INT16U, 2, 0, ReadUint16<kPhysicalMaxMireds>, nullptr)                          \
+    X(ColorControl, StartUpColorTemperatureMireds, INT16U, 2, ZAP_ATTRIBUTE_MASK(WRITABLE), ReadMireds, nullptr)                \
+    X(ColorControl, FeatureMap, BITMAP32, 4, 0, ReadColorFeatureMap, nullptr)
+
+#define BRIDGED_DEVICE_BASIC_ATTRIBUTES(X)                                                                                         \
+    X(BridgedDeviceBasicInformation, VendorName, CHAR_STRING, kNodeLabelSize, 0, ReadVendorName, nullptr)                       \
+    X(BridgedDeviceBasicInformation, ProductName, CHAR_STRING, kNodeLabelSize, 0, ReadProductName, nullptr)                     \
+    X(BridgedDeviceBasicInformation, SerialNumber, CHAR_STRING, kNodeLabelSize, 0, ReadSerialNumber, nullptr)                   \
+    X(BridgedDeviceBasicInformation, NodeLabel, CHAR_STRING, kNodeLabelSize, 0, ReadNodeLabel, nullptr)                         \
+    X(BridgedDeviceBasicInformation, Reachable, BOOLEAN, 1, 0, ReadReachable, nullptr)                                          \
+    X(BridgedDeviceBasicInformation, FeatureMap, BITMAP32, 4, 0,                                                                \
+      ReadUint32<ZCL_BRIDGED_DEVICE_BASIC_INFORMATION_FEATURE_MAP>, nullptr)
+
+#define DECLARE_ATTRIBUTE(cluster, attribute, type, size, mask, reader, writer)                                                    \
+    DECLARE_DYNAMIC_ATTRIBUTE(cluster::Attributes::attribute::Id, type, size, mask),
+
 // Declare Identify cluster attributes
 DECLARE_DYNAMIC_ATTRIBUTE_LIST_BEGIN(identifyAttrs)
-DECLARE_DYNAMIC_ATTRIBUTE(Identify::Attributes::IdentifyTime::Id, INT16U, 2, ZAP_ATTRIBUTE_MASK(WRITABLE)),
-    DECLARE_DYNAMIC_ATTRIBUTE(Identify::Attributes::IdentifyType::Id, BITMAP8, 1, 0), DECLARE_DYNAMIC_ATTRIBUTE_LIST_END();
+IDENTIFY_ATTRIBUTES(DECLARE_ATTRIBUTE) DECLARE_DYNAMIC_ATTRIBUTE_LIST_END();
 
 // Declare On/Off cluster attributes
 DECLARE_DYNAMIC_ATTRIBUTE_LIST_BEGIN(onOffAttrs)
-DECLARE_DYNAMIC_ATTRIBUTE(OnOff::Attributes::OnOff::Id, BOOLEAN, 1, 0), /* on/off */
-    DECLARE_DYNAMIC_ATTRIBUTE_LIST_END();
+ON_OFF_ATTRIBUTES(DECLARE_ATTRIBUTE) DECLARE_DYNAMIC_ATTRIBUTE_LIST_END();
 
 // Declare Light Control cluster attributes
 DECLARE_DYNAMIC_ATTRIBUTE_LIST_BEGIN(levelControlAttrs)
-DECLARE_DYNAMIC_ATTRIBUTE(LevelControl::Attributes::CurrentLevel::Id, INT8U, 1, ZAP_ATTRIBUTE_MASK(NULLABLE)),
-    DECLARE_DYNAMIC_ATTRIBUTE(LevelControl::Attributes::RemainingTime::Id, INT16U, 2, 0),
-    DECLARE_DYNAMIC_ATTRIBUTE(LevelControl::Attributes::MinLevel::Id, INT8U, 1, 0),
-    // TODO: Spec says this is mandatory but it doesn't seem to be?
-    // DECLARE_DYNAMIC_ATTRIBUTE(LevelControl::Attributes::OnLevel::Id, INT8U, 1,
-    //                           ZAP_ATTRIBUTE_MASK(WRITABLE) | ZAP_ATTRIBUTE_MASK(NULLABLE)),
-    DECLARE_DYNAMIC_ATTRIBUTE(LevelControl::Attributes::Options::Id, BITMAP8, 1, ZAP_ATTRIBUTE_MASK(WRITABLE)),
-    DECLARE_DYNAMIC_ATTRIBUTE(LevelControl::Attributes::StartUpCurrentLevel::Id, INT8U, 1, ZAP_ATTRIBUTE_MASK(WRITABLE)),
-    DECLARE_DYNAMIC_ATTRIBUTE(LevelControl::Attributes::ClusterRevision::Id, INT16U, 2, 0),
-    DECLARE_DYNAMIC_ATTRIBUTE(LevelControl::Attributes::FeatureMap::Id, BITMAP32, 4, 0), DECLARE_DYNAMIC_ATTRIBUTE_LIST_END();
+LEVEL_CONTROL_ATTRIBUTES(DECLARE_ATTRIBUTE) DECLARE_DYNAMIC_ATTRIBUTE_LIST_END();
 
 // Declare Color Control cluster attributes
 DECLARE_DYNAMIC_ATTRIBUTE_LIST_BEGIN(colorControlAttrs)
-DECLARE_DYNAMIC_ATTRIBUTE(ColorControl::Attributes::CurrentHue::Id, INT8U, 1, 0),
-    DECLARE_DYNAMIC_ATTRIBUTE(ColorControl::Attributes::CurrentSaturation::Id, INT8U, 1, 0),
-    DECLARE_DYNAMIC_ATTRIBUTE(ColorControl::Attributes::ColorTemperatureMireds::Id, INT16U, 2, 0),
-    DECLARE_DYNAMIC_ATTRIBUTE(ColorControl::Attributes::ColorMode::Id, ENUM8, 1, 0),
-    DECLARE_DYNAMIC_ATTRIBUTE(ColorControl::Attributes::Options::Id, BITMAP8, 1, ZAP_ATTRIBUTE_MASK(WRITABLE)),
-    DECLARE_DYNAMIC_ATTRIBUTE(ColorControl::Attributes::EnhancedColorMode::Id, ENUM8, 1, 0),
-    DECLARE_DYNAMIC_ATTRIBUTE(ColorControl::Attributes::ColorCapabilities::Id, BITMAP16, 2, 0),
-    DECLARE_DYNAMIC_ATTRIBUTE(ColorControl::Attributes::ColorTempPhysicalMinMireds::Id, INT16U, 2, 0),
-    DECLARE_DYNAMIC_ATTRIBUTE(ColorControl::Attributes::ColorTempPhysicalMaxMireds::Id, INT16U, 2, 0),
-    DECLARE_DYNAMIC_ATTRIBUTE(ColorControl::Attributes::StartUpColorTemperatureMireds::Id, INT16U, 2, ZAP_ATTRIBUTE_MASK(WRITABLE)),
-    DECLARE_DYNAMIC_ATTRIBUTE(ColorControl::Attributes::FeatureMap::Id, BITMAP32, 4, 0), DECLARE_DYNAMIC_ATTRIBUTE_LIST_END();
+COLOR_CONTROL_ATTRIBUTES(DECLARE_ATTRIBUTE) DECLARE_DYNAMIC_ATTRIBUTE_LIST_END();
 
 // Declare Descriptor cluster attributes
 DECLARE_DYNAMIC_ATTRIBUTE_LIST_BEGIN(descriptorAttrs)
@@ -171,14 +212,7 @@ DECLARE_DYNAMIC_ATTRIBUTE(Descriptor::Attributes::DeviceTypeList::Id, ARRAY, kDe
 
 // Declare Bridged Device Basic Information cluster attributes
 DECLARE_DYNAMIC_ATTRIBUTE_LIST_BEGIN(bridgedDeviceBasicAttrs)
-DECLARE_DYNAMIC_ATTRIBUTE(BridgedDeviceBasicInformation::Attributes::VendorName::Id, CHAR_STRING, kNodeLabelSize, 0),
-    DECLARE_DYNAMIC_ATTRIBUTE(BridgedDeviceBasicInformation::Attributes::ProductName::Id, CHAR_STRING, kNodeLabelSize, 0),
-    DECLARE_DYNAMIC_ATTRIBUTE(BridgedDeviceBasicInformation::Attributes::SerialNumber::Id, CHAR_STRING, kNodeLabelSize, 0),
-    DECLARE_DYNAMIC_ATTRIBUTE(BridgedDeviceBasicInformation::Attributes::NodeLabel::Id, CHAR_STRING, kNodeLabelSize,
-                              0),                                                                         /* NodeLabel */
-    DECLARE_DYNAMIC_ATTRIBUTE(BridgedDeviceBasicInformation::Attributes::Reachable::Id, BOOLEAN, 1, 0),   /* Reachable */
-    DECLARE_DYNAMIC_ATTRIBUTE(BridgedDeviceBasicInformation::Attributes::FeatureMap::Id, BITMAP32, 4, 0), /* feature map */
-    DECLARE_DYNAMIC_ATTRIBUTE_LIST_END();
+BRIDGED_DEVICE_BASIC_ATTRIBUTES(DECLARE_ATTRIBUTE) DECLARE_DYNAMIC_ATTRIBUTE_LIST_END();
 
 // Declare Cluster List for Bridged Light endpoint
 // TODO: It's not clear whether it would be better to get the command lists from
@@ -239,7 +273,15 @@ DECLARE_DYNAMIC_ENDPOINT(bridgedLightEndpoint, bridgedLightClusters);
 wled::KVS * kvs;
 wled::MDNS * mdns;
 std::vector<std::string> deny_list;
+std::vector<std::string> udp_sync_list;
 std::vector<WLED *> gLights;
+// Serializes adding and removing lights between startup, mDNS and the FIFO
+std::mutex gLightsMutex;
+// Stored lights that are still connecting, their endpoint indices stay reserved until they are added
+std::vector<std::tuple<uint8_t, WLED *>> gStartingLights;
+// Which light owns each dynamic endpoint index, guarded by gLightsMutex. gDevices only catches up once the CHIP thread
+// has applied the queued change, so the light threads pick and look up indices here instead.
+std::array<WLED *, CHIP_DEVICE_CONFIG_DYNAMIC_ENDPOINT_COUNT> gLightSlots{};
 std::array<std::array<DataVersion, MATTER_ARRAY_SIZE(bridgedLightClusters)>, CHIP_DEVICE_CONFIG_DYNAMIC_ENDPOINT_COUNT>
     gDataVersions;
 
@@ -264,63 +306,154 @@ Action action1(0x1001, "Room 1 On", Actions::ActionTypeEnum::kAutomation, 0xE001
 
 // ---------------------------------------------------------------------------
 
+// Endpoint changes are requested from the light threads (startup, mDNS, the monitor loop) but have to be applied on
+// the CHIP thread. Requests are serialized by gLightsMutex, so the ring only ever has one producer at a time.
+struct EndpointChange
+{
+    enum Kind : uint8_t
+    {
+        kAdd,
+        kRemove,
+    };
+
+    Kind kind                = kAdd;
+    uint8_t index            = 0;
+    Device * dev             = nullptr;
+    EmberAfEndpointType * ep = nullptr;
+    Span<const EmberAfDeviceType> deviceTypeList;
+    Span<DataVersion> dataVersionStorage;
+    chip::EndpointId parentEndpointId = chip::kInvalidEndpointId;
+};
+
+wled::SpscRing<EndpointChange, 64> gEndpointChanges;
+// Changes that didn't fit in the ring. While anything is queued here later changes go behind it so they are still
+// applied in order. `gEndpointSpilled` is only set by the producer and only cleared by the drain once it took them all.
+std::deque<EndpointChange> gEndpointOverflow;
+std::mutex gEndpointOverflowMutex;
+std::atomic<bool> gEndpointSpilled{ false };
+// At most one DrainEndpointChanges() is queued on the CHIP thread at a time
+std::atomic<bool> gEndpointDrainScheduled{ false };
+
+// Runs on the CHIP thread, or with the stack locked
+void ApplyEndpointChange(const EndpointChange & change)
+{
+    uint8_t index = change.index;
+    Device * dev  = change.dev;
+
+    if (change.kind == EndpointChange::kRemove)
+    {
+        if (gDevices[index] != dev)
+            return;
+        // Silence complaints about unused ep when progress logging
+        // disabled.
+        [[maybe_unused]] EndpointId ep = emberAfClearDynamicEndpoint(index);
+        gDevices[index]                = nullptr;
+        ChipLogProgress(DeviceLayer, "Removed device %s from dynamic endpoint %d (index=%d)", dev->GetName(), ep, index);
+        return;
+    }
+
+    if (gDevices[index] != nullptr)
+    {
+        ChipLogError(DeviceLayer, "Could not add device at index %d, it appears already used!", index);
+        return;
+    }
+
+    dev->SetEndpointId(index + gFirstDynamicEndpointId);
+    dev->SetParentEndpointId(change.parentEndpointId);
+    CHIP_ERROR err = emberAfSetDynamicEndpoint(index, index + gFirstDynamicEndpointId, change.ep, change.dataVersionStorage,
+                                               change.deviceTypeList, change.parentEndpointId);
+    if (err != CHIP_NO_ERROR)
+    {
+        ChipLogError(DeviceLayer, "Could not add device %s to dynamic endpoint %d: %" CHIP_ERROR_FORMAT, dev->GetName(),
+                     index + gFirstDynamicEndpointId, err.Format());
+        return;
+    }
+
+    gDevices[index] = dev;
+    ChipLogProgress(DeviceLayer, "Added device %s to dynamic endpoint %d (index=%d)", dev->GetName(),
+                    index + gFirstDynamicEndpointId, index);
+    // TODO: This won't work for every device! Does that matter?
+    // Seems to be tracked here: https://github.com/orgs/project-chip/projects/85
+    emberAfLevelControlClusterServerInitCallback(dev->GetEndpointId());
+    emberAfColorControlClusterServerInitCallback(dev->GetEndpointId());
+}
+
+void DrainEndpointChanges(intptr_t)
+{
+    // Cleared first, anything pushed while this runs queues another pass
+    gEndpointDrainScheduled = false;
+
+    EndpointChange change;
+    while (gEndpointChanges.pop(change))
+        ApplyEndpointChange(change);
+
+    if (!gEndpointSpilled.load(std::memory_order_acquire))
+        return;
+
+    std::deque<EndpointChange> overflow;
+    {
+        std::lock_guard lock(gEndpointOverflowMutex);
+        overflow.swap(gEndpointOverflow);
+        gEndpointSpilled.store(false, std::memory_order_release);
+    }
+    for (auto & queued : overflow)
+        ApplyEndpointChange(queued);
+}
+
+void PostEndpointChange(const EndpointChange & change)
+{
+    // Never drop an endpoint. The ring only fills up if the CHIP thread is stuck, and callers hold gLightsMutex which
+    // the CHIP thread may be waiting on, so spill onto the side rather than locking the stack.
+    if (gEndpointSpilled.load(std::memory_order_acquire) || !gEndpointChanges.push(change))
+    {
+        std::lock_guard lock(gEndpointOverflowMutex);
+        if (!gEndpointSpilled.exchange(true, std::memory_order_acq_rel))
+            ChipLogError(DeviceLayer, "Endpoint change queue full (%zu overflows)", gEndpointChanges.overflows());
+        gEndpointOverflow.push_back(change);
+    }
+
+    if (!gEndpointDrainScheduled.exchange(true))
+        PlatformMgr().ScheduleWork(DrainEndpointChanges);
+}
+
+// The endpoint shows up once the CHIP thread gets to it, callers must hold gLightsMutex
 int AddDeviceEndpoint(uint8_t index, Device * dev, EmberAfEndpointType * ep, const Span<const EmberAfDeviceType> & deviceTypeList,
                       const Span<DataVersion> & dataVersionStorage, chip::EndpointId parentEndpointId = chip::kInvalidEndpointId)
 {
-    if (nullptr == gDevices[index])
+    if (index >= CHIP_DEVICE_CONFIG_DYNAMIC_ENDPOINT_COUNT)
     {
-        gDevices[index] = dev;
-        CHIP_ERROR err;
-        while (true)
-        {
-            // Todo: Update this to schedule the work rather than use this lock
-            DeviceLayer::StackLock lock;
-            dev->SetEndpointId(index + gFirstDynamicEndpointId);
-            dev->SetParentEndpointId(parentEndpointId);
-            err = emberAfSetDynamicEndpoint(index, index + gFirstDynamicEndpointId, ep, dataVersionStorage, deviceTypeList,
-                                            parentEndpointId);
-            if (err == CHIP_NO_ERROR)
-            {
-                ChipLogProgress(DeviceLayer, "Added device %s to dynamic endpoint %d (index=%d)", dev->GetName(),
-                                index + gFirstDynamicEndpointId, index);
-                // TODO: This won't work for every device! Does that matter?
-                // Seems to be tracked here: https://github.com/orgs/project-chip/projects/85
-                emberAfLevelControlClusterServerInitCallback(dev->GetEndpointId());
-                emberAfColorControlClusterServerInitCallback(dev->GetEndpointId());
-                return index;
-            }
-            if (err != CHIP_ERROR_ENDPOINT_EXISTS)
-            {
-                gDevices[index] = nullptr;
-                return -1;
-            }
-        }
+        ChipLogError(DeviceLayer, "Could not add device at index %d, it is out of range!", index);
+        return -1;
     }
 
-    ChipLogError(DeviceLayer, "Could not add device at index %d, it appears already used!", index);
-    return -1;
+    EndpointChange change;
+    change.kind               = EndpointChange::kAdd;
+    change.index              = index;
+    change.dev                = dev;
+    change.ep                 = ep;
+    change.deviceTypeList     = deviceTypeList;
+    change.dataVersionStorage = dataVersionStorage;
+    change.parentEndpointId   = parentEndpointId;
+    PostEndpointChange(change);
+    return index;
 }
 
-// TODO: This needs to be modified later if we intend to call it
-int RemoveDeviceEndpoint(Device * dev)
+// The endpoint goes away once the CHIP thread gets to it, callers must hold gLightsMutex. gDevices isn't read here, the
+// add may well still be queued.
+int RemoveDeviceEndpoint(uint8_t index, Device * dev)
 {
-    uint8_t index = 0;
-    while (index < CHIP_DEVICE_CONFIG_DYNAMIC_ENDPOINT_COUNT)
+    if (index >= CHIP_DEVICE_CONFIG_DYNAMIC_ENDPOINT_COUNT)
     {
-        if (gDevices[index] == dev)
-        {
-            // Todo: Update this to schedule the work rather than use this lock
-            DeviceLayer::StackLock lock;
-            // Silence complaints about unused ep when progress logging
-            // disabled.
-            [[maybe_unused]] EndpointId ep = emberAfClearDynamicEndpoint(index);
-            gDevices[index]                = nullptr;
-            ChipLogProgress(DeviceLayer, "Removed device %s from dynamic endpoint %d (index=%d)", dev->GetName(), ep, index);
-            return index;
-        }
-        index++;
+        ChipLogError(DeviceLayer, "Could not remove device at index %d, it is out of range!", index);
+        return -1;
     }
-    return -1;
+
+    EndpointChange change;
+    change.kind  = EndpointChange::kRemove;
+    change.index = index;
+    change.dev   = dev;
+    PostEndpointChange(change);
+    return index;
 }
 
 std::vector<EndpointListInfo> GetEndpointListInfo(chip::EndpointId parentId)
@@ -374,17 +507,66 @@ std::vector<Room *> GetRoomListInfo(chip::EndpointId parentId)
 }
 
 namespace {
-void CallReportingCallback(intptr_t closure)
+// Bit positions in Device::MarkDirty(), one per reportable attribute of a bridged light
+enum ReportedAttribute : uint32_t
+{
+    kReportReachable,
+    kReportNodeLabel,
+    kReportOnOff,
+    kReportCurrentLevel,
+    kReportRemainingTime,
+    kReportColorTemperatureMireds,
+    kReportCurrentHue,
+    kReportCurrentSaturation,
+    kReportCount,
+};
+
+constexpr struct
 {
-    auto path = reinterpret_cast<app::ConcreteAttributePath *>(closure);
-    MatterReportingAttributeChangeCallback(*path);
-    Platform::Delete(path);
+    ClusterId cluster;
+    AttributeId attribute;
+} kReportedPaths[kReportCount] = {
+    { BridgedDeviceBasicInformation::Id, BridgedDeviceBasicInformation::Attributes::Reachable::Id },
+    { BridgedDeviceBasicInformation::Id, BridgedDeviceBasicInformation::Attributes::NodeLabel::Id },
+    { OnOff::Id, OnOff::Attributes::OnOff::Id },
+    { LevelControl::Id, LevelControl::Attributes::CurrentLevel::Id },
+    { LevelControl::Id, LevelControl::Attributes::RemainingTime::Id },
+    { ColorControl::Id, ColorControl::Attributes::ColorTemperatureMireds::Id },
+    { ColorControl::Id, ColorControl::Attributes::CurrentHue::Id },
+    { ColorControl::Id, ColorControl::Attributes::CurrentSaturation::Id },
+};
+
+// At most one FlushReports() is queued on the CHIP thread at a time
+std::atomic<bool> gReportFlushScheduled{ false };
+
+// Reports everything marked dirty since the last pass, for every endpoint, in one go
+void FlushReports(intptr_t)
+{
+    // Cleared first, anything marked while this runs queues another pass
+    gReportFlushScheduled = false;
+
+    for (auto * dev : gDevices)
+    {
+        if (dev == nullptr)
+            continue;
+
+        uint32_t dirty = dev->TakeDirty();
+        gMetrics.report_backlog.add(-__builtin_popcount(dirty));
+        for (uint32_t bit = 0; dirty != 0; bit++, dirty >>= 1)
+        {
+            if (dirty & 1)
+                MatterReportingAttributeChangeCallback(dev->GetEndpointId(), kReportedPaths[bit].cluster,
+                                                       kReportedPaths[bit].attribute);
+        }
+    }
 }
 
-void ScheduleReportingCallback(Device * dev, ClusterId cluster, AttributeId attribute)
+void ScheduleReportingCallback(Device * dev, ReportedAttribute attribute)
 {
-    auto * path = Platform::New<app::ConcreteAttributePath>(dev->GetEndpointId(), cluster, attribute);
-    PlatformMgr().ScheduleWork(CallReportingCallback, reinterpret_cast<intptr_t>(path));
+    if (!(dev->MarkDirty(1u << attribute) & (1u << attribute)))
+        gMetrics.report_backlog.add(1);
+    if (!gReportFlushScheduled.exchange(true))
+        PlatformMgr().ScheduleWork(FlushReports);
 }
 } // anonymous namespace
 
@@ -392,12 +574,12 @@ void HandleDeviceStatusChanged(Device * dev, Device::Changed_t itemChangedMask)
 {
     if (itemChangedMask & Device::kChanged_Reachable)
     {
-        ScheduleReportingCallback(dev, BridgedDeviceBasicInformation::Id, BridgedDeviceBasicInformation::Attributes::Reachable::Id);
+        ScheduleReportingCallback(dev, kReportReachable);
     }
 
     if (itemChangedMask & Device::kChanged_Name)
     {
-        ScheduleReportingCallback(dev, BridgedDeviceBasicInformation::Id, BridgedDeviceBasicInformation::Attributes::NodeLabel::Id);
+        ScheduleReportingCallback(dev, kReportNodeLabel);
     }
 }
 
@@ -410,7 +592,7 @@ void HandleDeviceOnOffStatusChanged(DeviceOnOff * dev, DeviceOnOff::Changed_t it
 
     if (itemChangedMask & DeviceOnOff::kChanged_OnOff)
     {
-        ScheduleReportingCallback(dev, OnOff::Id, OnOff::Attributes::OnOff::Id);
+        ScheduleReportingCallback(dev, kReportOnOff);
     }
 }
 
@@ -423,7 +605,8 @@ void HandleDeviceDimmableStatusChanged(DeviceDimmable * dev, DeviceDimmable::Cha
 
     if (itemChangedMask & DeviceDimmable::kChanged_Level)
     {
-        ScheduleReportingCallback(dev, LevelControl::Id, LevelControl::Attributes::CurrentLevel::Id);
+        ScheduleReportingCallback(dev, kReportCurrentLevel);
+        ScheduleReportingCallback(dev, kReportRemainingTime);
     }
 }
 
@@ -436,7 +619,7 @@ void HandleDeviceColorTemperatureStatusChanged(DeviceColorTemperature * dev, Dev
 
     if (itemChangedMask & DeviceColorTemperature::kChanged_Mireds)
     {
-        ScheduleReportingCallback(dev, ColorControl::Id, ColorControl::Attributes::ColorTemperatureMireds::Id);
+        ScheduleReportingCallback(dev, kReportColorTemperatureMireds);
     }
 }
 
@@ -449,12 +632,12 @@ void HandleDeviceExtendedColorStatusChanged(DeviceExtendedColor * dev, DeviceExt
 
     if (itemChangedMask & DeviceExtendedColor::kChanged_Hue)
     {
-        ScheduleReportingCallback(dev, ColorControl::Id, ColorControl::Attributes::CurrentHue::Id);
+        ScheduleReportingCallback(dev, kReportCurrentHue);
     }
 
     if (itemChangedMask & DeviceExtendedColor::kChanged_Saturation)
     {
-        ScheduleReportingCallback(dev, ColorControl::Id, ColorControl::Attributes::CurrentSaturation::Id);
+        ScheduleReportingCallback(dev, kReportCurrentSaturation);
     }
 }
 
@@ -469,433 +652,316 @@ void unhandled_attribute()
 #endif
 }
 
-Protocols::InteractionModel::Status HandleReadBridgedDeviceBasicAttribute(Device * dev, chip::AttributeId attributeId,
-                                                                          uint8_t * buffer, uint16_t maxReadLength)
+namespace {
+
+// WLED's white balance range, in kelvin
+constexpr int WLED_KELVIN_MIN = 1900;
+constexpr int WLED_KELVIN_MAX = 10091;
+
+constexpr uint16_t kPhysicalMinMireds = static_cast<uint16_t>((1000000 + WLED_KELVIN_MAX - 1) / WLED_KELVIN_MAX);
+constexpr uint16_t kPhysicalMaxMireds = static_cast<uint16_t>(1000000 / WLED_KELVIN_MIN);
+
+// Readers fill exactly the attribute's declared size, writers get the buffer the ember server decoded
+using AttributeReader = void (*)(WLED & light, uint8_t * buffer, uint16_t size);
+using AttributeWriter = void (*)(WLED & light, const uint8_t * buffer);
+
+template <uint8_t value>
+void ReadUint8(WLED &, uint8_t * buffer, uint16_t)
 {
-    using namespace BridgedDeviceBasicInformation::Attributes;
+    *buffer = value;
+}
 
-    ChipLogProgress(DeviceLayer, "HandleReadBridgedDeviceBasicAttribute: attrId=%d, maxReadLength=%d", attributeId, maxReadLength);
+template <uint16_t value>
+void ReadUint16(WLED &, uint8_t * buffer, uint16_t)
+{
+    uint16_t copy = value;
+    memcpy(buffer, &copy, sizeof(copy));
+}
 
-    if ((attributeId == Reachable::Id) && (maxReadLength == 1))
-    {
-        *buffer = dev->IsReachable() ? 1 : 0;
-    }
-    else if ((attributeId == NodeLabel::Id) && (maxReadLength == 32))
-    {
-        MutableByteSpan zclNameSpan(buffer, maxReadLength);
-        MakeZclCharString(zclNameSpan, dev->GetName());
-    }
-    else if ((attributeId == ClusterRevision::Id) && (maxReadLength == 2))
-    {
-        uint16_t rev = ZCL_BRIDGED_DEVICE_BASIC_INFORMATION_CLUSTER_REVISION;
-        memcpy(buffer, &rev, sizeof(rev));
-    }
-    else if ((attributeId == FeatureMap::Id) && (maxReadLength == 4))
-    {
-        uint32_t featureMap = ZCL_BRIDGED_DEVICE_BASIC_INFORMATION_FEATURE_MAP;
-        memcpy(buffer, &featureMap, sizeof(featureMap));
-    }
-    else if ((attributeId == VendorName::Id) && (maxReadLength == 32))
-    {
-        MutableByteSpan zclNameSpan(buffer, maxReadLength);
-        MakeZclCharString(zclNameSpan, dev->GetManufacturer().c_str());
-    }
-    else if ((attributeId == ProductName::Id) && (maxReadLength == 32))
-    {
-        MutableByteSpan zclNameSpan(buffer, maxReadLength);
-        MakeZclCharString(zclNameSpan, dev->GetModel().c_str());
-    }
-    else if ((attributeId == SerialNumber::Id) && (maxReadLength == 32))
-    {
-        MutableByteSpan zclNameSpan(buffer, maxReadLength);
-        MakeZclCharString(zclNameSpan, dev->GetSerialNumber().c_str());
-    }
-    else
-    {
-        unhandled_attribute();
-        return Protocols::InteractionModel::Status::Failure;
-    }
+template <uint32_t value>
+void ReadUint32(WLED &, uint8_t * buffer, uint16_t)
+{
+    uint32_t copy = value;
+    memcpy(buffer, &copy, sizeof(copy));
+}
 
-    return Protocols::InteractionModel::Status::Success;
+void ReadString(const char * value, uint8_t * buffer, uint16_t size)
+{
+    MutableByteSpan zclNameSpan(buffer, size);
+    MakeZclCharString(zclNameSpan, value);
 }
 
-Protocols::InteractionModel::Status HandleReadIdentifyAttribute(Device * dev, chip::AttributeId attributeId, uint8_t * buffer,
-                                                                uint16_t maxReadLength)
+void ReadIdentifyTime(WLED & light, uint8_t * buffer, uint16_t)
 {
-    ChipLogProgress(DeviceLayer, "HandleReadIdentifyAttribute: attrId=%d, maxReadLength=%d", attributeId, maxReadLength);
+    uint16_t time = light.IdentifyTime();
+    memcpy(buffer, &time, sizeof(time));
+}
 
-    if ((attributeId == Identify::Attributes::IdentifyTime::Id) && (maxReadLength == 2))
-    {
-        uint16_t time = dev->IdentifyTime();
-        memcpy(buffer, &time, 2);
-        ChipLogProgress(DeviceLayer, "Identify::Attributes::IdentifyTime: %d", time);
-    }
-    else if ((attributeId == Identify::Attributes::IdentifyType::Id) && (maxReadLength == 1))
-    {
-        *buffer = (uint8_t) Identify::IdentifyTypeEnum::kLightOutput;
-        ChipLogProgress(DeviceLayer, "Identify::Attributes::IdentifyTypeEnum: %d", *buffer);
-    }
-    else if ((attributeId == Identify::Attributes::ClusterRevision::Id) && (maxReadLength == 2))
-    {
-        uint16_t rev = ZCL_IDENTIFY_CLUSTER_REVISION;
-        memcpy(buffer, &rev, 2);
-        ChipLogProgress(DeviceLayer, "Identify::Attributes::ClusterRevision: %d", rev);
-    }
-    else
-    {
-        unhandled_attribute();
-        return Protocols::InteractionModel::Status::Failure;
-    }
-    return Protocols::InteractionModel::Status::Success;
+void ReadIdentifyType(WLED &, uint8_t * buffer, uint16_t)
+{
+    *buffer = static_cast<uint8_t>(Identify::IdentifyTypeEnum::kLightOutput);
 }
 
-Protocols::InteractionModel::Status HandleReadOnOffAttribute(DeviceOnOff * dev, chip::AttributeId attributeId, uint8_t * buffer,
-                                                             uint16_t maxReadLength)
+void ReadOnOff(WLED & light, uint8_t * buffer, uint16_t)
 {
-    ChipLogProgress(DeviceLayer, "HandleReadOnOffAttribute: attrId=%d, maxReadLength=%d", attributeId, maxReadLength);
+    *buffer = light.IsOn() ? 1 : 0;
+}
 
-    if ((attributeId == OnOff::Attributes::OnOff::Id) && (maxReadLength == 1))
-    {
-        *buffer = dev->IsOn() ? 1 : 0;
-        ChipLogProgress(DeviceLayer, "OnOff::Attributes::OnOff: %d", *buffer);
-    }
-    else if ((attributeId == OnOff::Attributes::ClusterRevision::Id) && (maxReadLength == 2))
-    {
-        uint16_t rev = ZCL_ON_OFF_CLUSTER_REVISION;
-        memcpy(buffer, &rev, sizeof(rev));
-        ChipLogProgress(DeviceLayer, "OnOff::ClusterRevision::OnOff: %d", rev);
-    }
-    else
-    {
-        unhandled_attribute();
-        return Protocols::InteractionModel::Status::Failure;
-    }
+void ReadCurrentLevel(WLED & light, uint8_t * buffer, uint16_t)
+{
+    *buffer = light.Level();
+}
 
-    return Protocols::InteractionModel::Status::Success;
+void ReadRemainingTime(WLED & light, uint8_t * buffer, uint16_t)
+{
+    uint16_t remaining = light.LevelRemainingTime();
+    memcpy(buffer, &remaining, sizeof(remaining));
 }
 
-Protocols::InteractionModel::Status HandleReadLevelControlAttribute(DeviceDimmable * dev, chip::AttributeId attributeId,
-                                                                    uint8_t * buffer, uint16_t maxReadLength)
+void ReadHue(WLED & light, uint8_t * buffer, uint16_t)
 {
-    ChipLogProgress(DeviceLayer, "HandleReadLevelControlAttribute: attrId=%d, maxReadLength=%d", attributeId, maxReadLength);
+    *buffer = light.Hue();
+}
 
-    if ((attributeId == LevelControl::Attributes::CurrentLevel::Id) && (maxReadLength == 1))
-    {
-        *buffer = dev->Level();
-        ChipLogProgress(DeviceLayer, "LevelControl::Attributes::CurrentLevel: %d", *buffer);
-    }
-    else if ((attributeId == LevelControl::Attributes::RemainingTime::Id) && (maxReadLength == 2))
-    {
-        *(uint16_t *) buffer = 0;
-        ChipLogProgress(DeviceLayer, "LevelControl::Attributes::RemainingTime: %d", *buffer);
-    }
-    else if ((attributeId == LevelControl::Attributes::MinLevel::Id) && (maxReadLength == 1))
-    {
-        *buffer = 0;
-        ChipLogProgress(DeviceLayer, "LevelControl::Attributes::MinLevel: %d", *buffer);
-    }
-    else if ((attributeId == LevelControl::Attributes::Options::Id) && (maxReadLength == 1))
-    {
-        *buffer = ZCL_LEVEL_CONTROL_OPTIONS;
-        ChipLogProgress(DeviceLayer, "LevelControl::Attributes::Options: %d", *buffer);
-    }
-    else if ((attributeId == LevelControl::Attributes::StartUpCurrentLevel::Id) && (maxReadLength == 1))
-    {
-        *buffer = dev->Level();
-        ChipLogProgress(DeviceLayer, "LevelControl::Attributes::StartUpCurrentLevel: %d", *buffer);
-    }
-    else if ((attributeId == LevelControl::Attributes::ClusterRevision::Id) && (maxReadLength == 2))
-    {
-        uint16_t rev = ZCL_LEVEL_CONTROL_CLUSTER_REVISION;
-        memcpy(buffer, &rev, sizeof(rev));
-        ChipLogProgress(DeviceLayer, "LevelControl::Attributes::ClusterRevision: %d", *buffer);
-    }
-    else if ((attributeId == LevelControl::Attributes::FeatureMap::Id) && (maxReadLength == 4))
-    {
-        uint32_t featureMap = ZCL_LEVEL_CONTROL_FEATURE_MAP;
-        memcpy(buffer, &featureMap, sizeof(featureMap));
-        ChipLogProgress(DeviceLayer, "LevelControl::Attributes::FeatureMap: %d", *buffer);
-    }
-    else
-    {
-        unhandled_attribute();
-        return Protocols::InteractionModel::Status::Failure;
-    }
+void ReadSaturation(WLED & light, uint8_t * buffer, uint16_t)
+{
+    *buffer = light.Saturation();
+}
 
-    return Protocols::InteractionModel::Status::Success;
+void ReadMireds(WLED & light, uint8_t * buffer, uint16_t)
+{
+    uint16_t mireds = light.Mireds();
+    memcpy(buffer, &mireds, sizeof(mireds));
 }
 
-Protocols::InteractionModel::Status HandleReadColorControlAttribute(DeviceColorTemperature * dev, chip::AttributeId attributeId,
-                                                                    uint8_t * buffer, uint16_t maxReadLength)
+void ReadColorMode(WLED & light, uint8_t * buffer, uint16_t)
 {
-    ChipLogProgress(DeviceLayer, "HandleReadColorControlAttribute: attrId=%d, maxReadLength=%d", attributeId, maxReadLength);
-    if ((attributeId == ColorControl::Attributes::CurrentHue::Id) && (maxReadLength == 1))
-    {
-        *buffer = dev->Hue();
-        ChipLogProgress(DeviceLayer, "ColorControl::Attributes::CurrentHue: %d", *buffer);
-    }
-    else if ((attributeId == ColorControl::Attributes::CurrentSaturation::Id) && (maxReadLength == 1))
-    {
-        *buffer = dev->Saturation();
-        ChipLogProgress(DeviceLayer, "ColorControl::Attributes::CurrentSaturation: %d", *buffer);
-    }
-    else if ((attributeId == ColorControl::Attributes::ColorTemperatureMireds::Id) && (maxReadLength == 2))
-    {
-        uint16_t level = dev->Mireds();
-        memcpy(buffer, &level, sizeof(level));
-        ChipLogProgress(DeviceLayer, "ColorControl::Attributes::ColorTemperatureMireds: %d", *(uint16_t *) buffer);
-    }
-    else if ((attributeId == ColorControl::Attributes::ColorMode::Id) && (maxReadLength == 1))
-    {
-        *buffer = dev->ColorMode();
-        ChipLogProgress(DeviceLayer, "ColorControl::Attributes::ColorMode: %d", *buffer);
-    }
-    else if ((attributeId == ColorControl::Attributes::Options::Id) && (maxReadLength == 1))
-    {
-        *buffer = ZCL_COLOR_CONTROL_OPTIONS;
-        ChipLogProgress(DeviceLayer, "ColorControl::Attributes::Options: %d", *buffer);
-    }
-    else if ((attributeId == ColorControl::Attributes::EnhancedColorMode::Id) && (maxReadLength == 1))
-    {
-        *buffer = dev->ColorMode();
-        ChipLogProgress(DeviceLayer, "ColorControl::Attributes::EnhancedColorMode: %d", *buffer);
-    }
-    else if ((attributeId == ColorControl::Attributes::StartUpColorTemperatureMireds::Id) && (maxReadLength == 2))
-    {
-        uint16_t level = dev->Mireds();
-        memcpy(buffer, &level, sizeof(level));
-        ChipLogProgress(DeviceLayer, "ColorControl::Attributes::StartUpColorTemperatureMireds: %d", *(uint16_t *) buffer);
-    }
-    else if ((attributeId == ColorControl::Attributes::ColorCapabilities::Id) && (maxReadLength == 2))
-    {
-        uint16_t featureMap = dev->Capabilities();
-        memcpy(buffer, &featureMap, sizeof(featureMap));
-        ChipLogProgress(DeviceLayer, "ColorControl::Attributes::ColorCapabilities: %d", *(uint16_t *) buffer);
-    }
-    else if ((attributeId == ColorControl::Attributes::ColorTempPhysicalMinMireds::Id) && (maxReadLength == 2))
-    {
-        constexpr int WLED_KELVIN_MAX = 10091;
-        uint16_t minK                 = static_cast<uint16_t>(ceil(1000000.0 / WLED_KELVIN_MAX));
-        memcpy(buffer, &minK, sizeof(minK));
-        ChipLogProgress(DeviceLayer, "ColorControl::Attributes::ColorTempPhysicalMinMireds: %d", *(uint16_t *) buffer);
-    }
-    else if ((attributeId == ColorControl::Attributes::ColorTempPhysicalMaxMireds::Id) && (maxReadLength == 2))
-    {
-        constexpr int WLED_KELVIN_MIN = 1900;
-        uint16_t maxK                 = static_cast<uint16_t>(floor(1000000.0 / WLED_KELVIN_MIN));
-        memcpy(buffer, &maxK, sizeof(maxK));
-        ChipLogProgress(DeviceLayer, "ColorControl::Attributes::ColorTempPhysicalMaxMireds: %d", *(uint16_t *) buffer);
-    }
-    else if ((attributeId == ColorControl::Attributes::FeatureMap::Id) && (maxReadLength == 4))
-    {
-        uint32_t featureMap = dev->Capabilities();
-        memcpy(buffer, &featureMap, sizeof(featureMap));
-        ChipLogProgress(DeviceLayer, "ColorControl::Attributes::FeatureMap: %d", *(uint32_t *) buffer);
-    }
-    else if ((attributeId == ColorControl::Attributes::ClusterRevision::Id) && (maxReadLength == 2))
-    {
-        uint16_t rev = ZCL_COLOR_CONTROL_CLUSTER_REVISION;
-        memcpy(buffer, &rev, sizeof(rev));
-        ChipLogProgress(DeviceLayer, "ColorControl::Attributes::ClusterRevision: %d", *(uint16_t *) buffer);
-    }
-    else
-    {
-        unhandled_attribute();
-        return Protocols::InteractionModel::Status::Failure;
-    }
+    *buffer = light.ColorMode();
+}
 
-    return Protocols::InteractionModel::Status::Success;
+void ReadColorCapabilities(WLED & light, uint8_t * buffer, uint16_t)
+{
+    uint16_t capabilities = light.Capabilities();
+    memcpy(buffer, &capabilities, sizeof(capabilities));
 }
 
-Protocols::InteractionModel::Status HandleWriteIdentifyAttribute(Device * dev, chip::AttributeId attributeId, uint8_t * buffer)
+void ReadColorFeatureMap(WLED & light, uint8_t * buffer, uint16_t)
 {
-    ChipLogProgress(DeviceLayer, "HandleWriteIdentifyAttribute: attrId=%d", attributeId);
-    if ((attributeId == Identify::Attributes::IdentifyTime::Id) && (dev->IsReachable()))
-    {
-        uint16_t time = *(uint16_t *) buffer;
-        dev->Identify(time);
-        ChipLogProgress(DeviceLayer, "Identify::Attributes::Identify: %d", time);
-    }
-    else
-    {
-        unhandled_attribute();
-        return Protocols::InteractionModel::Status::Failure;
-    }
+    uint32_t featureMap = light.Capabilities();
+    memcpy(buffer, &featureMap, sizeof(featureMap));
+}
 
-    return Protocols::InteractionModel::Status::Success;
+void ReadVendorName(WLED & light, uint8_t * buffer, uint16_t size)
+{
+    ReadString(light.Snapshot().manufacturer, buffer, size);
 }
 
-Protocols::InteractionModel::Status HandleWriteOnOffAttribute(DeviceOnOff * dev, chip::AttributeId attributeId, uint8_t * buffer)
+void ReadProductName(WLED & light, uint8_t * buffer, uint16_t size)
 {
-    ChipLogProgress(DeviceLayer, "HandleWriteOnOffAttribute: attrId=%d", attributeId);
+    ReadString(light.Snapshot().model, buffer, size);
+}
 
-    if ((attributeId == OnOff::Attributes::OnOff::Id) && (dev->IsReachable()))
-    {
-        if (*buffer)
-        {
-            dev->SetOnOff(true);
-        }
-        else
-        {
-            dev->SetOnOff(false);
-        }
-        ChipLogProgress(DeviceLayer, "OnOff::Attributes::OnOff: %d", *buffer);
-    }
-    else
-    {
-        unhandled_attribute();
-        return Protocols::InteractionModel::Status::Failure;
-    }
+void ReadSerialNumber(WLED & light, uint8_t * buffer, uint16_t size)
+{
+    ReadString(light.Snapshot().serial_number, buffer, size);
+}
 
-    return Protocols::InteractionModel::Status::Success;
+void ReadNodeLabel(WLED & light, uint8_t * buffer, uint16_t size)
+{
+    ReadString(light.GetName(), buffer, size);
 }
 
-Protocols::InteractionModel::Status HandleWriteLevelControlAttribute(DeviceDimmable * dev, chip::AttributeId attributeId,
-                                                                     uint8_t * buffer)
+void ReadReachable(WLED & light, uint8_t * buffer, uint16_t)
 {
-    ChipLogProgress(DeviceLayer, "HandleWriteLevelControlAttribute: attrId=%d", attributeId);
+    *buffer = light.IsReachable() ? 1 : 0;
+}
 
-    if ((attributeId == LevelControl::Attributes::CurrentLevel::Id) && (dev->IsReachable()))
-    {
-        dev->SetLevel(*buffer);
-        ChipLogProgress(DeviceLayer, "LevelControl::Attributes::CurrentLevel: %d", *buffer);
-    }
-    else if ((attributeId == LevelControl::Attributes::RemainingTime::Id) && (dev->IsReachable()))
-    {
-        // TODO: This should not be writable???? Why is this getting called????
-        ChipLogProgress(DeviceLayer, "LevelControl::Attributes::RemainingTime: %d", *buffer);
-    }
-    else
-    {
-        unhandled_attribute();
-        return Protocols::InteractionModel::Status::Failure;
-    }
+void WriteIdentifyTime(WLED & light, const uint8_t * buffer)
+{
+    uint16_t time;
+    memcpy(&time, buffer, sizeof(time));
+    light.Identify(time);
+}
 
-    return Protocols::InteractionModel::Status::Success;
+void WriteOnOff(WLED & light, const uint8_t * buffer)
+{
+    light.SetOnOff(*buffer != 0);
 }
 
-Protocols::InteractionModel::Status HandleWriteColorControlAttribute(DeviceColorTemperature * dev, chip::AttributeId attributeId,
-                                                                     uint8_t * buffer)
+void WriteCurrentLevel(WLED & light, const uint8_t * buffer)
 {
-    ChipLogProgress(DeviceLayer, "HandleWriteColorControlAttribute: attrId=%d", attributeId);
+    light.SetLevel(*buffer);
+}
 
-    if ((attributeId == ColorControl::Attributes::CurrentHue::Id) && (dev->IsReachable()))
-    {
-        dev->SetHue(*buffer);
-        ChipLogProgress(DeviceLayer, "ColorControl::Attributes::CurrentHue: %d", *buffer);
-    }
-    else if ((attributeId == ColorControl::Attributes::CurrentSaturation::Id) && (dev->IsReachable()))
-    {
-        dev->SetSaturation(*buffer);
-        ChipLogProgress(DeviceLayer, "ColorControl::Attributes::CurrentSaturation: %d", *buffer);
-    }
-    else if ((attributeId == ColorControl::Attributes::ColorTemperatureMireds::Id) && (dev->IsReachable()))
-    {
-        uint16_t mireds = *(uint16_t *) buffer;
-        dev->SetMireds(mireds);
-        ChipLogProgress(DeviceLayer, "ColorControl::Attributes::ColorTemperatureMireds: %d", mireds);
-    }
-    else if ((attributeId == ColorControl::Attributes::ColorMode::Id) && (dev->IsReachable()))
-    {
-        // TODO: This should not be writable???? Why is this getting called????
-        dev->SetColorMode(*(uint8_t *) (buffer));
-        ChipLogProgress(DeviceLayer, "ColorControl::Attributes::ColorMode: %d", *buffer);
-    }
-    else if ((attributeId == ColorControl::Attributes::EnhancedColorMode::Id) && (dev->IsReachable()))
+// TODO: These should not be writable???? Why are they getting called????
+void WriteIgnored(WLED &, const uint8_t *) {}
+
+void WriteColorMode(WLED & light, const uint8_t * buffer)
+{
+    light.SetColorMode(*buffer);
+}
+
+void WriteHue(WLED & light, const uint8_t * buffer)
+{
+    light.SetHue(*buffer);
+}
+
+void WriteSaturation(WLED & light, const uint8_t * buffer)
+{
+    light.SetSaturation(*buffer);
+}
+
+void WriteMireds(WLED & light, const uint8_t * buffer)
+{
+    uint16_t mireds;
+    memcpy(&mireds, buffer, sizeof(mireds));
+    light.SetMireds(mireds);
+}
+
+struct AttributeAccessor
+{
+    AttributeId id;
+    uint16_t size;
+    AttributeReader read;
+    AttributeWriter write;
+    const char * name;
+};
+
+#define ATTRIBUTE_ACCESSOR(cluster, attribute, type, size, mask, reader, writer)                                                   \
+    { cluster::Attributes::attribute::Id, size, reader, writer, #cluster "::" #attribute },
+#define CLUSTER_REVISION_ACCESSOR(cluster, revision)                                                                               \
+    ATTRIBUTE_ACCESSOR(cluster, ClusterRevision, INT16U, 2, 0, ReadUint16<revision>, nullptr)
+
+constexpr AttributeAccessor kIdentifyAccessors[] = { IDENTIFY_ATTRIBUTES(ATTRIBUTE_ACCESSOR)
+                                                         CLUSTER_REVISION_ACCESSOR(Identify, ZCL_IDENTIFY_CLUSTER_REVISION) };
+constexpr AttributeAccessor kOnOffAccessors[]    = { ON_OFF_ATTRIBUTES(ATTRIBUTE_ACCESSOR)
+                                                      CLUSTER_REVISION_ACCESSOR(OnOff, ZCL_ON_OFF_CLUSTER_REVISION) };
+constexpr AttributeAccessor kLevelControlAccessors[] = { LEVEL_CONTROL_ATTRIBUTES(ATTRIBUTE_ACCESSOR)
+                                                             CLUSTER_REVISION_ACCESSOR(LevelControl,
+                                                                                       ZCL_LEVEL_CONTROL_CLUSTER_REVISION) };
+constexpr AttributeAccessor kColorControlAccessors[] = { COLOR_CONTROL_ATTRIBUTES(ATTRIBUTE_ACCESSOR)
+                                                             CLUSTER_REVISION_ACCESSOR(ColorControl,
+                                                                                       ZCL_COLOR_CONTROL_CLUSTER_REVISION) };
+constexpr AttributeAccessor kBridgedDeviceBasicAccessors[] = {
+    BRIDGED_DEVICE_BASIC_ATTRIBUTES(ATTRIBUTE_ACCESSOR)
+        CLUSTER_REVISION_ACCESSOR(BridgedDeviceBasicInformation, ZCL_BRIDGED_DEVICE_BASIC_INFORMATION_CLUSTER_REVISION)
+};
+
+#undef CLUSTER_REVISION_ACCESSOR
+#undef ATTRIBUTE_ACCESSOR
+
+struct ClusterAccessors
+{
+    ClusterId id;
+    const AttributeAccessor * begin;
+    const AttributeAccessor * end;
+};
+
+constexpr ClusterAccessors kClusterAccessors[] = {
+    { Identify::Id, std::begin(kIdentifyAccessors), std::end(kIdentifyAccessors) },
+    { OnOff::Id, std::begin(kOnOffAccessors), std::end(kOnOffAccessors) },
+    { LevelControl::Id, std::begin(kLevelControlAccessors), std::end(kLevelControlAccessors) },
+    { ColorControl::Id, std::begin(kColorControlAccessors), std::end(kColorControlAccessors) },
+    { BridgedDeviceBasicInformation::Id, std::begin(kBridgedDeviceBasicAccessors), std::end(kBridgedDeviceBasicAccessors) },
+};
+
+const AttributeAccessor * FindAccessor(ClusterId clusterId, AttributeId attributeId)
+{
+    for (const auto & cluster : kClusterAccessors)
     {
-        // TODO: This should not be writable???? Why is this getting called????
-        dev->SetColorMode(*(uint8_t *) (buffer));
-        ChipLogProgress(DeviceLayer, "ColorControl::Attributes::EnhancedColorMode: %d", *buffer);
+        if (cluster.id != clusterId)
+            continue;
+
+        for (auto accessor = cluster.begin; accessor != cluster.end; ++accessor)
+        {
+            if (accessor->id == attributeId)
+                return accessor;
+        }
+        return nullptr;
     }
+
+    ChipLogError(DeviceLayer, "Unknown cluster ID: %d\n", clusterId);
+    return nullptr;
+}
+
+// Every dynamic endpoint is a WLED light
+WLED * LookupLight(EndpointId endpoint)
+{
+    uint16_t index = emberAfGetDynamicIndexFromEndpoint(endpoint);
+    if (index >= CHIP_DEVICE_CONFIG_DYNAMIC_ENDPOINT_COUNT)
+        return nullptr;
+    return static_cast<WLED *>(gDevices[index]);
+}
+
+// Set from WLED_TRACE_ATTRIBUTES. Subscriptions read every attribute of every light, so only the binary trace sees
+// them by default.
+bool gTraceAttributes = false;
+
+void TraceAttribute(wled::trace::Event event, EndpointId endpoint, const AttributeAccessor & accessor, const uint8_t * buffer)
+{
+    // Strings are traced by length
+    uint32_t value = 0;
+    if (accessor.size > sizeof(value))
+        value = buffer[0];
     else
-    {
-        unhandled_attribute();
-        return Protocols::InteractionModel::Status::Failure;
-    }
+        memcpy(&value, buffer, accessor.size);
+    wled::trace::record(event, endpoint, value, accessor.name);
 
-    return Protocols::InteractionModel::Status::Success;
+    if (!gTraceAttributes)
+        return;
+
+    const char * access = event == wled::trace::Event::kAttributeRead ? "Read" : "Write";
+    if (accessor.size > sizeof(value))
+        ChipLogProgress(DeviceLayer, "%s %s on endpoint %d: \"%.*s\"", access, accessor.name, endpoint, buffer[0],
+                        reinterpret_cast<const char *>(buffer + 1));
+    else
+        ChipLogProgress(DeviceLayer, "%s %s on endpoint %d: %u", access, accessor.name, endpoint, static_cast<unsigned>(value));
 }
 
+} // namespace
+
 Protocols::InteractionModel::Status emberAfExternalAttributeReadCallback(EndpointId endpoint, ClusterId clusterId,
                                                                          const EmberAfAttributeMetadata * attributeMetadata,
                                                                          uint8_t * buffer, uint16_t maxReadLength)
 {
-    uint16_t endpointIndex = emberAfGetDynamicIndexFromEndpoint(endpoint);
-
-    Protocols::InteractionModel::Status ret = Protocols::InteractionModel::Status::Failure;
+    WLED * light = LookupLight(endpoint);
+    if (light == nullptr)
+        return Protocols::InteractionModel::Status::Failure;
 
-    if ((endpointIndex < CHIP_DEVICE_CONFIG_DYNAMIC_ENDPOINT_COUNT) && (gDevices[endpointIndex] != nullptr))
+    const AttributeAccessor * accessor = FindAccessor(clusterId, attributeMetadata->attributeId);
+    if (accessor == nullptr || accessor->size != maxReadLength)
     {
-        Device * dev = gDevices[endpointIndex];
-
-        if (clusterId == BridgedDeviceBasicInformation::Id)
-        {
-            ret = HandleReadBridgedDeviceBasicAttribute(dev, attributeMetadata->attributeId, buffer, maxReadLength);
-        }
-        else if (clusterId == Identify::Id)
-        {
-            ret = HandleReadIdentifyAttribute(static_cast<Device *>(dev), attributeMetadata->attributeId, buffer, maxReadLength);
-        }
-        else if (clusterId == OnOff::Id)
-        {
-            ret = HandleReadOnOffAttribute(static_cast<DeviceOnOff *>(dev), attributeMetadata->attributeId, buffer, maxReadLength);
-        }
-        else if (clusterId == LevelControl::Id)
-        {
-            ret = HandleReadLevelControlAttribute(static_cast<DeviceDimmable *>(dev), attributeMetadata->attributeId, buffer,
-                                                  maxReadLength);
-        }
-        else if (clusterId == ColorControl::Id)
-        {
-            ret = HandleReadColorControlAttribute(static_cast<DeviceColorTemperature *>(dev), attributeMetadata->attributeId,
-                                                  buffer, maxReadLength);
-        }
-        else
-        {
-            ChipLogError(DeviceLayer, "Unknown cluster ID: %d\n", clusterId);
-        }
+        unhandled_attribute();
+        return Protocols::InteractionModel::Status::Failure;
     }
 
-    return ret;
+    accessor->read(*light, buffer, maxReadLength);
+    TraceAttribute(wled::trace::Event::kAttributeRead, endpoint, *accessor, buffer);
+
+    return Protocols::InteractionModel::Status::Success;
 }
 
 Protocols::InteractionModel::Status emberAfExternalAttributeWriteCallback(EndpointId endpoint, ClusterId clusterId,
                                                                           const EmberAfAttributeMetadata * attributeMetadata,
                                                                           uint8_t * buffer)
 {
-    uint16_t endpointIndex = emberAfGetDynamicIndexFromEndpoint(endpoint);
-
-    Protocols::InteractionModel::Status ret = Protocols::InteractionModel::Status::Failure;
+    WLED * light = LookupLight(endpoint);
+    if (light == nullptr || !light->IsReachable())
+        return Protocols::InteractionModel::Status::Failure;
 
-    if (endpointIndex < CHIP_DEVICE_CONFIG_DYNAMIC_ENDPOINT_COUNT)
+    const AttributeAccessor * accessor = FindAccessor(clusterId, attributeMetadata->attributeId);
+    if (accessor == nullptr || accessor->write == nullptr)
     {
-        Device * dev = gDevices[endpointIndex];
-
-        if (!dev->IsReachable())
-        {
-            return ret;
-        }
-
-        if (clusterId == Identify::Id)
-        {
-            ret = HandleWriteIdentifyAttribute(static_cast<Device *>(dev), attributeMetadata->attributeId, buffer);
-        }
-        if (clusterId == OnOff::Id)
-        {
-            ret = HandleWriteOnOffAttribute(static_cast<DeviceOnOff *>(dev), attributeMetadata->attributeId, buffer);
-        }
-        if (clusterId == LevelControl::Id)
-        {
-            ret = HandleWriteLevelControlAttribute(static_cast<DeviceDimmable *>(dev), attributeMetadata->attributeId, buffer);
-        }
-        if (clusterId == ColorControl::Id)
-        {
-            ret = HandleWriteColorControlAttribute(static_cast<DeviceColorTemperature *>(dev), attributeMetadata->attributeId,
-                                                   buffer);
-        }
+        unhandled_attribute();
+        return Protocols::InteractionModel::Status::Failure;
     }
 
-    return ret;
+    // Commands this write stages are timed from here, see wled::CommandStage
+    wled::ReceivedScope received(std::chrono::steady_clock::now());
+    TraceAttribute(wled::trace::Event::kAttributeWrite, endpoint, *accessor, buffer);
+    accessor->write(*light, buffer);
+
+    return Protocols::InteractionModel::Status::Success;
 }
 
 void runOnOffRoomAction(Room * room, bool actionOn, EndpointId endpointId, uint16_t actionID, uint32_t invokeID, bool hasInvokeID)
@@ -907,6 +973,35 @@ void runOnOffRoomAction(Room * room, bool actionOn, EndpointId endpointId, uint1
         chip::app::LogEvent(event, endpointId, eventNumber);
     }
 
+    // Lights are never freed, a copy is enough to not hold gLightsMutex while staging
+    std::vector<WLED *> lights;
+    {
+        std::lock_guard lock(gLightsMutex);
+        lights = gLights;
+    }
+
+    // Serialize every member's command first so the sends themselves are a tight loop over the sockets
+    std::vector<std::pair<WLED *, WLED::Staged>> staged;
+    for (auto light : lights)
+    {
+        std::string location =
+            room->getType() == Actions::EndpointListTypeEnum::kZone ? light->GetZone() : light->GetLocation();
+        if (light->IsReachable() && room->getName().compare(location) == 0)
+            staged.emplace_back(light, light->StageOnOff(actionOn));
+    }
+
+    if (!staged.empty())
+    {
+        auto first = std::chrono::steady_clock::now();
+        for (auto & [light, command] : staged)
+            light->SendStaged(command);
+        auto skew = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - first);
+
+        gMetrics.room_send_skew.record(skew);
+        ChipLogProgress(DeviceLayer, "%s turned %s on %u lights, send skew %lldus", room->getName().c_str(),
+                        actionOn ? "on" : "off", static_cast<unsigned>(staged.size()), static_cast<long long>(skew.count()));
+    }
+
     if (hasInvokeID)
     {
         Actions::Events::StateChanged::Type event{ actionID, invokeID, Actions::ActionStateEnum::kInactive };
@@ -931,129 +1026,109 @@ bool kbhit()
 int wled_monitor_pipe[2];
 int wled_fifo_in_fd;
 
+// Driven by wled_monitoring_thread
+wled::Reactor gReactor;
+wled::TimerWheel gTimerWheel;
+wled::Coalescer gCoalescer(gTimerWheel, gReactor);
+wled::ReconnectManager gReconnects(gTimerWheel, gReactor);
+wled::MetricsRegistry gMetrics;
+wled::MetricsExporter gMetricsExporter(gMetrics);
+// How long a connection may stay silent, pings included, before the light is treated as gone
+std::chrono::milliseconds gKeepaliveBudget{ 15000 };
+
+wled::LevelControlHandler gLevelControlHandler(LookupLight);
+wled::ColorControlHandler gColorControlHandler(LookupLight);
+
 bool add_wled_by_ip(std::string ip);
 bool remove_wled_by_ip(std::string ip);
 
-void * wled_monitoring_thread(void * context)
+void handle_fifo_command()
 {
-    int result;
-    fd_set rfds;
-    int nfds;
-
-    while (true)
+    int wled_fifo_out_fd = open(WLED_FIFO_OUT, O_WRONLY);
+    if (wled_fifo_out_fd == -1)
     {
-        FD_ZERO(&rfds);
-        FD_SET(wled_monitor_pipe[0], &rfds);
-        nfds = wled_monitor_pipe[0];
+        perror("open");
+        exit(1);
+    }
 
-        FD_SET(wled_fifo_in_fd, &rfds);
-        nfds = std::max(nfds, wled_fifo_in_fd);
+    ssize_t read_bytes = 0;
 
-        for (auto & light : gLights)
-        {
-            if (light->IsReachable())
-            {
-                FD_SET(light->socket(), &rfds);
-                nfds = std::max(nfds, light->socket());
-            }
-        }
+    char operation[1];
+    read_bytes = read(wled_fifo_in_fd, operation, sizeof(operation));
+    if (read_bytes < 0)
+        ChipLogError(DeviceLayer, "Could not read from FIFO");
 
-        result = select(nfds + 1, &rfds, nullptr, nullptr, nullptr);
-        if (result == -1)
+    char buf[100]{};
+    read_bytes = read(wled_fifo_in_fd, buf, sizeof(buf) - 1);
+    if (read_bytes < 0)
+    {
+        ChipLogError(DeviceLayer, "Could not read from FIFO");
+        if (write(wled_fifo_out_fd, "1", 1) < 1)
+            ChipLogError(DeviceLayer, "Could not write!");
+    }
+    else
+    {
+        bool success = false;
+        if (operation[0] == '1')
         {
-            perror("select");
-            abort();
+            ChipLogProgress(DeviceLayer, "Adding device: %s", buf);
+            success = add_wled_by_ip(std::string(buf));
         }
-
-        if (FD_ISSET(wled_monitor_pipe[0], &rfds))
+        else if (operation[0] == '2')
         {
-            char buf[1];
-            // Don't care what it is, just breaking out of select
-            if (read(wled_monitor_pipe[0], &buf, 1) < 0)
-                ChipLogError(DeviceLayer, "Could not read from FIFO");
+            ChipLogProgress(DeviceLayer, "Removing device: %s", buf);
+            success = remove_wled_by_ip(std::string(buf));
         }
-
-        if (FD_ISSET(wled_fifo_in_fd, &rfds))
+        else if (operation[0] == '3')
         {
-            int wled_fifo_out_fd = open(WLED_FIFO_OUT, O_WRONLY);
-            if (wled_fifo_out_fd == -1)
-            {
-                perror("open");
-                exit(1);
-            }
-
-            ssize_t read_bytes = 0;
+            auto & inst = LinuxDeviceOptions::GetInstance();
 
-            char operation[1];
-            read_bytes = read(wled_fifo_in_fd, operation, sizeof(operation));
-            if (read_bytes < 0)
-                ChipLogError(DeviceLayer, "Could not read from FIFO");
+            char payloadBuffer[chip::QRCodeBasicSetupPayloadGenerator::kMaxQRCodeBase38RepresentationLength + 1];
+            chip::MutableCharSpan qrCode(payloadBuffer);
 
-            char buf[100]{};
-            read_bytes = read(wled_fifo_in_fd, buf, sizeof(buf) - 1);
-            if (read_bytes < 0)
+            CHIP_ERROR err = GetQRCode(qrCode, inst.payload);
+            if (err != CHIP_NO_ERROR)
             {
-                ChipLogError(DeviceLayer, "Could not read from FIFO");
-                if (write(wled_fifo_out_fd, "1", 1) < 1)
-                    ChipLogError(DeviceLayer, "Could not write!");
+                char error_str[255];
+                chip::FormatCHIPError(error_str, sizeof(error_str), err);
+                ChipLogError(DeviceLayer, "%s", error_str);
             }
             else
             {
-                bool success = false;
-                if (operation[0] == '1')
-                {
-                    ChipLogProgress(DeviceLayer, "Adding device: %s", buf);
-                    success = add_wled_by_ip(std::string(buf));
-                }
-                else if (operation[0] == '2')
-                {
-                    ChipLogProgress(DeviceLayer, "Removing device: %s", buf);
-                    success = remove_wled_by_ip(std::string(buf));
-                }
-                else if (operation[0] == '3')
-                {
-                    auto & inst = LinuxDeviceOptions::GetInstance();
-
-                    char payloadBuffer[chip::QRCodeBasicSetupPayloadGenerator::kMaxQRCodeBase38RepresentationLength + 1];
-                    chip::MutableCharSpan qrCode(payloadBuffer);
-
-                    CHIP_ERROR err = GetQRCode(qrCode, inst.payload);
-                    if (err != CHIP_NO_ERROR)
-                    {
-                        char error_str[255];
-                        chip::FormatCHIPError(error_str, sizeof(error_str), err);
-                        ChipLogError(DeviceLayer, "%s", error_str);
-                    }
-                    else
-                    {
-                        ChipLogProgress(DeviceLayer, "%s", qrCode.data());
-                        if (write(wled_fifo_out_fd, qrCode.data(), qrCode.size()) < (int) qrCode.size())
-                            ChipLogError(DeviceLayer, "Could not write!");
-                    }
-                }
-                else
-                {
-                    ChipLogError(DeviceLayer, "Got unknown operation: %s", operation);
-                }
-
-                if (operation[0] != '3')
-                    if (write(wled_fifo_out_fd, success ? "0" : "1", 1) < 1)
-                        ChipLogError(DeviceLayer, "Could not write!");
+                ChipLogProgress(DeviceLayer, "%s", qrCode.data());
+                if (write(wled_fifo_out_fd, qrCode.data(), qrCode.size()) < (int) qrCode.size())
+                    ChipLogError(DeviceLayer, "Could not write!");
             }
-
-            close(wled_fifo_out_fd);
         }
-
-        for (auto & light : gLights)
+        else if (operation[0] == '4')
         {
-            if (FD_ISSET(light->socket(), &rfds))
-            {
-                ChipLogProgress(DeviceLayer, "%s is ready to update!", light->GetName());
-                light->update();
-            }
+            wled::trace::dump(wled_fifo_out_fd);
+        }
+        else
+        {
+            ChipLogError(DeviceLayer, "Got unknown operation: %s", operation);
         }
+
+        if (operation[0] != '3' && operation[0] != '4')
+            if (write(wled_fifo_out_fd, success ? "0" : "1", 1) < 1)
+                ChipLogError(DeviceLayer, "Could not write!");
     }
 
+    close(wled_fifo_out_fd);
+}
+
+void * wled_monitoring_thread(void * context)
+{
+    // Lights may be added from the startup threads while this runs
+    auto lights = [](std::vector<WLED *> & out) {
+        std::lock_guard lock(gLightsMutex);
+        out = gLights;
+    };
+
+    wled::Monitor monitor(gReactor, gTimerWheel, wled_monitor_pipe[0], lights, gKeepaliveBudget);
+    monitor.watch(wled_fifo_in_fd, handle_fifo_command);
+    monitor.run();
+
     return nullptr;
 }
 
@@ -1064,6 +1139,12 @@ bool add_wled(uint8_t index, WLED * device)
         ChipLogError(DeviceLayer, "Could not add WLED (%s)", device->GetIP().c_str());
         return false;
     }
+    if (gLightSlots[index] != nullptr && gLightSlots[index] != device)
+    {
+        ChipLogError(DeviceLayer, "Could not add WLED (%s), index %d is taken by %s", device->GetIP().c_str(), index,
+                     gLightSlots[index]->GetIP().c_str());
+        return false;
+    }
 
     ChipLogProgress(DeviceLayer, "Adding WLED: %s (%s)", device->GetName(), device->GetIP().c_str());
     // TODO: Handle this a little more elegantly
@@ -1071,7 +1152,9 @@ bool add_wled(uint8_t index, WLED * device)
     device->DeviceDimmable::SetChangeCallback(&HandleDeviceDimmableStatusChanged);
     device->DeviceColorTemperature::SetChangeCallback(&HandleDeviceColorTemperatureStatusChanged);
     device->DeviceExtendedColor::SetChangeCallback(&HandleDeviceExtendedColorStatusChanged);
-    gDataVersions[index] = { 0 };
+
+    if (std::find(udp_sync_list.begin(), udp_sync_list.end(), device->GetIP()) != udp_sync_list.end())
+        device->EnableUdpSync();
 
     int ret =
         AddDeviceEndpoint(index, device, &bridgedLightEndpoint, Span<const EmberAfDeviceType>(gBridgedExtendedColorDeviceTypes),
@@ -1079,6 +1162,7 @@ bool add_wled(uint8_t index, WLED * device)
     if (ret < 0)
         return false;
 
+    gLightSlots[index] = device;
     kvs->store_wled(index, device);
     gLights.push_back(device);
 
@@ -1090,45 +1174,84 @@ bool add_wled(uint8_t index, WLED * device)
     return true;
 }
 
-bool add_wled_by_ip(std::string ip)
+// Hands a light that is done with its first connection attempt from gStartingLights over to gLights
+bool finish_starting_wled(uint8_t index, WLED * device)
 {
-    // Check if the IP is already known
-    for (auto & device : gLights)
+    std::lock_guard lock(gLightsMutex);
+    gStartingLights.erase(std::remove(gStartingLights.begin(), gStartingLights.end(), std::make_tuple(index, device)),
+                          gStartingLights.end());
+
+    if (add_wled(index, device) == true)
     {
-        if (device->GetIP() == ip)
-            return true;
+        ChipLogProgress(DeviceLayer, "Added WLED (%s) at index %d", device->GetName(), index);
+        return true;
     }
 
-    for (auto & deny_entry : deny_list)
+    ChipLogError(DeviceLayer, "Could not add WLED (%s) at index %d", device->GetName(), index);
+    return false;
+}
+
+bool add_wled_by_ip(std::string ip)
+{
+    uint8_t next_endpoint = CHIP_DEVICE_CONFIG_DYNAMIC_ENDPOINT_COUNT;
+    WLED * light          = nullptr;
     {
-        if (deny_entry == ip)
+        std::lock_guard lock(gLightsMutex);
+
+        // Check if the IP is already known
+        for (auto & device : gLights)
         {
-            ChipLogError(DeviceLayer, "Not adding %s - it is in the deny list", ip.c_str());
-            return false;
+            if (device->GetIP() == ip)
+                return true;
+        }
+        for (auto & [index, device] : gStartingLights)
+        {
+            if (device->GetIP() == ip)
+                return true;
         }
-    }
 
-    uint8_t next_endpoint                                     = CHIP_DEVICE_CONFIG_DYNAMIC_ENDPOINT_COUNT;
-    DataVersion temp[MATTER_ARRAY_SIZE(bridgedLightClusters)] = {};
+        for (auto & deny_entry : deny_list)
+        {
+            if (deny_entry == ip)
+            {
+                ChipLogError(DeviceLayer, "Not adding %s - it is in the deny list", ip.c_str());
+                return false;
+            }
+        }
 
-    for (uint8_t i = (uint8_t) gFirstDynamicEndpointId; i < CHIP_DEVICE_CONFIG_DYNAMIC_ENDPOINT_COUNT; i++)
-    {
-        if (memcmp(gDataVersions.at(i).data(), temp, sizeof(temp)) == 0)
+        for (uint8_t i = (uint8_t) gFirstDynamicEndpointId; i < CHIP_DEVICE_CONFIG_DYNAMIC_ENDPOINT_COUNT; i++)
         {
-            next_endpoint = i;
-            break;
+            bool reserved = std::any_of(gStartingLights.begin(), gStartingLights.end(),
+                                        [i](const auto & starting) { return std::get<0>(starting) == i; });
+            if (!reserved && gLightSlots[i] == nullptr)
+            {
+                next_endpoint = i;
+                break;
+            }
         }
+        if (next_endpoint == CHIP_DEVICE_CONFIG_DYNAMIC_ENDPOINT_COUNT)
+        {
+            ChipLogError(DeviceLayer, "Could not add WLED (%s), no free endpoint", ip.c_str());
+            return false;
+        }
+
+        // Reserve the IP and the index before letting go of the lock, so mDNS and the FIFO can't both pick them
+        light = new WLED(ip, "Office", false);
+        gStartingLights.push_back({ next_endpoint, light });
     }
 
-    auto light = new WLED(ip, "Office");
-    return add_wled(next_endpoint, light);
+    // Connects on gReconnects' workers like the stored lights, FIFO adds run on the monitor thread and must not block
+    // it. The endpoint shows up once the first attempt is over, true only means the light was accepted.
+    light->StartAsync([next_endpoint](WLED & started) { finish_starting_wled(next_endpoint, &started); });
+    return true;
 }
 
 bool remove_wled_by_ip(std::string ip)
 {
-    size_t index         = 0;
-    size_t devices_index = 0;
-    WLED * target        = nullptr;
+    std::lock_guard lock(gLightsMutex);
+
+    size_t index  = 0;
+    WLED * target = nullptr;
 
     // Check if the IP is already known
     for (; index < gLights.size(); index++)
@@ -1144,32 +1267,26 @@ bool remove_wled_by_ip(std::string ip)
     if (!target)
         return false;
 
-    for (; devices_index < CHIP_DEVICE_CONFIG_DYNAMIC_ENDPOINT_COUNT; devices_index++)
-    {
-        if (gDevices[devices_index] == target)
-        {
-            break;
-        }
-    }
-
-    int result = RemoveDeviceEndpoint(target);
-    if (!result)
+    auto slot = std::find(gLightSlots.begin(), gLightSlots.end(), target);
+    int result =
+        slot == gLightSlots.end() ? -1 : RemoveDeviceEndpoint(static_cast<uint8_t>(slot - gLightSlots.begin()), target);
+    if (result < 0)
     {
         ChipLogError(DeviceLayer, "Could not remove endpoint: %s", ip.c_str());
         return false;
     }
 
     gLights.erase(gLights.begin() + (int) index);
+    *slot = nullptr;
 
-    gDataVersions[devices_index] = { 0 };
-    result                       = kvs->delete_wled((uint8_t) devices_index);
+    bool deleted = kvs->delete_wled(static_cast<uint8_t>(result));
 
     // Tell the monitoring thread there is a new WLED device
     char buf[1] = { 1 };
     if (write(wled_monitor_pipe[1], buf, 1) < 1)
         ChipLogError(DeviceLayer, "Could not write!");
 
-    return result;
+    return deleted;
 }
 
 void * mdns_monitoring_thread(void * context)
@@ -1224,28 +1341,61 @@ void ApplicationInit()
 
     gRooms.push_back(&room1);
 
-    CURLcode code = curl_global_init(CURL_GLOBAL_DEFAULT);
-    if (code != CURLE_OK)
     {
-        printf("%s\n", curl_easy_strerror(code));
-        exit(1);
+        wled::Coalescer::Config config;
+        if (auto window = std::getenv("WLED_COALESCE_MS"))
+            config.window = std::chrono::milliseconds(std::stoi(window));
+        if (auto max_delay = std::getenv("WLED_COALESCE_MAX_MS"))
+            config.max_delay = std::chrono::milliseconds(std::stoi(max_delay));
+        gCoalescer.configure(config);
+        ChipLogProgress(DeviceLayer, "Coalescing commands for %lldms (max %lldms)",
+                        static_cast<long long>(config.window.count()), static_cast<long long>(config.max_delay.count()));
     }
 
-    kvs = new wled::KVS(CHIP_DEVICE_CONFIG_DYNAMIC_ENDPOINT_COUNT);
+    {
+        wled::ReconnectManager::Config config;
+        if (auto max_attempts = std::getenv("WLED_MAX_RECONNECTS"))
+            config.max_attempts = static_cast<size_t>(std::stoi(max_attempts));
+        gReconnects.configure(config);
+    }
+
+    gTraceAttributes = std::getenv("WLED_TRACE_ATTRIBUTES") != nullptr;
 
-    auto stored_devices = kvs->get_wleds();
-    for (auto & [index, device] : stored_devices)
     {
-        if (add_wled(index, device) == true)
-        {
-            ChipLogProgress(DeviceLayer, "Added WLED (%s) at index %d", device->GetName(), index);
-        }
-        else
+        wled::MetricsExporter::Config config;
+        if (auto port = std::getenv("WLED_METRICS_PORT"))
+            config.port = static_cast<uint16_t>(std::stoi(port));
+        if (auto address = std::getenv("WLED_METRICS_ADDRESS"))
+            config.address = address;
+        if (auto file = std::getenv("WLED_METRICS_FILE"))
+            config.file = file;
+        if (auto interval = std::getenv("WLED_METRICS_INTERVAL_MS"))
+            config.interval = std::chrono::milliseconds(std::stoi(interval));
+        if (!gMetricsExporter.start(config))
+            ChipLogError(DeviceLayer, "Metrics export disabled");
+    }
+
+    if (auto keepalive = std::getenv("WLED_KEEPALIVE_MS"))
+        gKeepaliveBudget = std::chrono::milliseconds(std::stoi(keepalive));
+
+    if (app::CommandHandlerInterfaceRegistry::Instance().RegisterCommandHandler(&gLevelControlHandler) != CHIP_NO_ERROR)
+        ChipLogError(DeviceLayer, "Failed to register LevelControl handler, transitions will be stepped locally");
+    if (app::CommandHandlerInterfaceRegistry::Instance().RegisterCommandHandler(&gColorControlHandler) != CHIP_NO_ERROR)
+        ChipLogError(DeviceLayer, "Failed to register ColorControl handler, transitions will be stepped locally");
+
+    char * udp_sync_string = std::getenv("WLED_UDP_SYNC");
+    if (udp_sync_string)
+    {
+        char * p = strtok(udp_sync_string, ",");
+        while (p != NULL)
         {
-            ChipLogError(DeviceLayer, "Could not add WLED (%s) at index %d", device->GetName(), index);
+            udp_sync_list.push_back(std::string(p));
+            p = strtok(NULL, ",");
         }
     }
 
+    kvs = new wled::KVS(CHIP_DEVICE_CONFIG_DYNAMIC_ENDPOINT_COUNT);
+
     char * deny_string = std::getenv("WLED_DENY_LIST");
     if (deny_string)
     {
@@ -1299,6 +1449,16 @@ void ApplicationInit()
         }
     }
 
+    // Bring stored lights up on gReconnects' workers, each one gets its endpoint as soon as its first attempt is over
+    {
+        auto stored_devices = kvs->get_wleds();
+
+        std::lock_guard lock(gLightsMutex);
+        gStartingLights = stored_devices;
+        for (auto & [index, device] : stored_devices)
+            device->StartAsync([index = index](WLED & started) { finish_starting_wled(index, &started); });
+    }
+
     char * disable_mdns = std::getenv("WLED_DISABLE_MDNS");
     if (disable_mdns)
     {
@@ -1323,6 +1483,8 @@ void ApplicationShutdown()
 
 int main(int argc, char * argv[])
 {
+    wled::trace::install_crash_handler();
+
     auto & inst = LinuxDeviceOptions::GetInstance();
 
     auto setup_code = std::getenv("WLED_SETUP_CODE");
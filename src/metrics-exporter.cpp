@@ -0,0 +1,228 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <lib/support/logging/CHIPLogging.h>
+
+#include "metrics-exporter.hpp"
+
+using namespace wled;
+
+namespace {
+constexpr int kRequestTimeoutMs = 1000;
+
+bool write_all(int fd, const char * data, size_t length)
+{
+    while (length > 0)
+    {
+        ssize_t written = ::send(fd, data, length, MSG_NOSIGNAL);
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written <= 0)
+            return false;
+        data += written;
+        length -= static_cast<size_t>(written);
+    }
+    return true;
+}
+} // namespace
+
+MetricsExporter::~MetricsExporter()
+{
+    stopping = true;
+    if (wakefd >= 0)
+    {
+        uint64_t one = 1;
+        if (write(wakefd, &one, sizeof(one)) < 0)
+            ChipLogError(DeviceLayer, "Could not wake metrics exporter: %s", strerror(errno));
+    }
+    if (thread.joinable())
+        thread.join();
+    if (listenfd >= 0)
+        close(listenfd);
+    if (wakefd >= 0)
+        close(wakefd);
+}
+
+bool MetricsExporter::start(const Config & aConfig)
+{
+    config = aConfig;
+    if (config.port == 0 && config.file.empty())
+        return true;
+
+    wakefd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (wakefd < 0)
+    {
+        ChipLogError(DeviceLayer, "eventfd: %s", strerror(errno));
+        return false;
+    }
+
+    if (config.port)
+    {
+        if (!listen_on(config.address, config.port))
+        {
+            if (listenfd >= 0)
+                close(listenfd);
+            listenfd = -1;
+            return false;
+        }
+        ChipLogProgress(DeviceLayer, "Serving metrics on %s port %u", config.address.c_str(), config.port);
+    }
+
+    if (!config.file.empty())
+        ChipLogProgress(DeviceLayer, "Writing metrics to %s every %lldms", config.file.c_str(),
+                        static_cast<long long>(config.interval.count()));
+
+    thread = std::thread(&MetricsExporter::run, this);
+    return true;
+}
+
+bool MetricsExporter::listen_on(const std::string & host, uint16_t port)
+{
+    sockaddr_storage address = {};
+    socklen_t length         = 0;
+    auto v4                  = reinterpret_cast<sockaddr_in *>(&address);
+    auto v6                  = reinterpret_cast<sockaddr_in6 *>(&address);
+    if (inet_pton(AF_INET6, host.c_str(), &v6->sin6_addr) == 1)
+    {
+        v6->sin6_family = AF_INET6;
+        v6->sin6_port   = htons(port);
+        length          = sizeof(*v6);
+    }
+    else if (inet_pton(AF_INET, host.c_str(), &v4->sin_addr) == 1)
+    {
+        v4->sin_family = AF_INET;
+        v4->sin_port   = htons(port);
+        length         = sizeof(*v4);
+    }
+    else
+    {
+        ChipLogError(DeviceLayer, "Not an IP address to serve metrics on: %s", host.c_str());
+        return false;
+    }
+
+    listenfd = socket(address.ss_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listenfd < 0)
+    {
+        ChipLogError(DeviceLayer, "socket: %s", strerror(errno));
+        return false;
+    }
+
+    int on  = 1;
+    int off = 0;
+    setsockopt(listenfd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    // "::" also takes IPv4 scrapers, through mapped addresses
+    if (address.ss_family == AF_INET6)
+        setsockopt(listenfd, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off));
+
+    if (bind(listenfd, reinterpret_cast<sockaddr *>(&address), length) < 0 || listen(listenfd, 4) < 0)
+    {
+        ChipLogError(DeviceLayer, "Could not serve metrics on %s port %u: %s", host.c_str(), port, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+void MetricsExporter::run()
+{
+    auto next_write = std::chrono::steady_clock::now();
+
+    while (!stopping)
+    {
+        int timeout = -1;
+        if (!config.file.empty())
+        {
+            auto now = std::chrono::steady_clock::now();
+            if (now >= next_write)
+            {
+                write_file();
+                next_write = now + config.interval;
+            }
+            timeout = static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(next_write - now).count());
+        }
+
+        pollfd fds[2] = { { wakefd, POLLIN, 0 }, { listenfd, POLLIN, 0 } };
+        int ready     = poll(fds, listenfd >= 0 ? 2 : 1, timeout);
+        if (ready < 0 && errno != EINTR)
+        {
+            ChipLogError(DeviceLayer, "poll: %s", strerror(errno));
+            return;
+        }
+
+        if (ready > 0 && listenfd >= 0 && (fds[1].revents & POLLIN))
+        {
+            int client = accept4(listenfd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (client >= 0)
+            {
+                // A client that stops reading must not wedge this thread, or the destructor waiting on it
+                timeval timeout = { kRequestTimeoutMs / 1000, (kRequestTimeoutMs % 1000) * 1000 };
+                setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+                serve(client);
+                close(client);
+            }
+        }
+    }
+}
+
+// One request per connection. Whatever was asked for, the answer is the metrics page.
+void MetricsExporter::serve(int client)
+{
+    // Drain the request headers so closing doesn't reset the connection before the client reads the answer
+    char request[2048];
+    size_t received = 0;
+    while (received < sizeof(request))
+    {
+        pollfd fd = { client, POLLIN, 0 };
+        if (poll(&fd, 1, kRequestTimeoutMs) <= 0)
+            return;
+
+        ssize_t result = recv(client, request + received, sizeof(request) - received, 0);
+        if (result <= 0)
+            return;
+        received += static_cast<size_t>(result);
+        if (memmem(request, received, "\r\n\r\n", 4) || memmem(request, received, "\n\n", 2))
+            break;
+    }
+
+    std::string body;
+    registry.render(body);
+
+    char header[160];
+    int length = snprintf(header, sizeof(header),
+                          "HTTP/1.1 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %zu\r\n"
+                          "Connection: close\r\n\r\n",
+                          body.size());
+    if (write_all(client, header, static_cast<size_t>(length)))
+        write_all(client, body.data(), body.size());
+}
+
+// Written next to the target and renamed over it, readers never see a half-written file
+void MetricsExporter::write_file()
+{
+    std::string body;
+    registry.render(body);
+
+    std::string temporary = config.file + ".tmp";
+    FILE * file           = fopen(temporary.c_str(), "w");
+    if (!file)
+    {
+        ChipLogError(DeviceLayer, "Could not open %s: %s", temporary.c_str(), strerror(errno));
+        return;
+    }
+
+    bool ok = fwrite(body.data(), 1, body.size(), file) == body.size();
+    ok      = fclose(file) == 0 && ok;
+    if (!ok || rename(temporary.c_str(), config.file.c_str()) < 0)
+    {
+        ChipLogError(DeviceLayer, "Could not write %s: %s", config.file.c_str(), strerror(errno));
+        unlink(temporary.c_str());
+    }
+}
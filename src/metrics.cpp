@@ -0,0 +1,294 @@
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <iterator>
+
+#include "metrics.hpp"
+
+using namespace wled;
+
+namespace {
+// Exported `le` boundaries run from 2^kFirstBoundBits to 2^kLastBoundBits microseconds (8us to ~16.8s). Powers of two
+// are the upper edges of histogram buckets, so the cumulative counts are exact.
+constexpr unsigned kFirstBoundBits = 3;
+constexpr unsigned kLastBoundBits  = 24;
+
+void append_escaped(std::string & out, const std::string & value)
+{
+    for (char c : value)
+    {
+        if (c == '\\' || c == '"')
+            out += '\\';
+        if (c == '\n')
+        {
+            out += "\\n";
+            continue;
+        }
+        out += c;
+    }
+}
+
+void append_number(std::string & out, uint64_t value)
+{
+    char buffer[24];
+    snprintf(buffer, sizeof(buffer), "%" PRIu64, value);
+    out += buffer;
+}
+
+void append_seconds(std::string & out, uint64_t micros)
+{
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.6f", static_cast<double>(micros) / 1e6);
+    out += buffer;
+}
+
+void append_header(std::string & out, const char * name, const char * type, const char * help)
+{
+    out += "# HELP ";
+    out += name;
+    out += ' ';
+    out += help;
+    out += "\n# TYPE ";
+    out += name;
+    out += ' ';
+    out += type;
+    out += '\n';
+}
+
+// `labels` is the already rendered label set without braces, `extra` is appended to it
+void append_sample(std::string & out, const char * name, const char * suffix, const std::string & labels,
+                   const std::string & extra, const std::string & value)
+{
+    out += name;
+    out += suffix;
+    if (!labels.empty() || !extra.empty())
+    {
+        out += '{';
+        out += labels;
+        if (!labels.empty() && !extra.empty())
+            out += ',';
+        out += extra;
+        out += '}';
+    }
+    out += ' ';
+    out += value;
+    out += '\n';
+}
+
+void append_histogram(std::string & out, const char * name, const std::string & labels, const Histogram & histogram)
+{
+    std::string value;
+    for (unsigned bits = kFirstBoundBits; bits <= kLastBoundBits; bits++)
+    {
+        std::string le = "le=\"";
+        append_seconds(le, uint64_t{ 1 } << bits);
+        le += '"';
+
+        value.clear();
+        append_number(value, histogram.count_at_most(uint64_t{ 1 } << bits));
+        append_sample(out, name, "_bucket", labels, le, value);
+    }
+
+    // Read once so +Inf and _count agree even while other threads record
+    uint64_t count = histogram.count();
+    value.clear();
+    append_number(value, count);
+    append_sample(out, name, "_bucket", labels, "le=\"+Inf\"", value);
+
+    value.clear();
+    append_seconds(value, histogram.sum());
+    append_sample(out, name, "_sum", labels, {}, value);
+
+    value.clear();
+    append_number(value, count);
+    append_sample(out, name, "_count", labels, {}, value);
+}
+
+struct HistogramFamily
+{
+    const char * name;
+    const char * help;
+    Histogram DeviceMetrics::*histogram;
+};
+
+constexpr HistogramFamily kHistograms[] = {
+    { "wled_command_send_seconds", "Time spent handing a command to the light's socket.", &DeviceMetrics::send_latency },
+    { "wled_state_parse_seconds", "Time spent parsing one state push from the light.", &DeviceMetrics::parse_time },
+};
+
+constexpr const char * kStageNames[] = { "coalesce", "send", "device", "total" };
+static_assert(std::size(kStageNames) == static_cast<size_t>(CommandStage::kCount), "Every command stage needs a name");
+
+struct CounterFamily
+{
+    const char * name;
+    const char * help;
+    Counter DeviceMetrics::*counter;
+};
+
+constexpr CounterFamily kCounters[] = {
+    { "wled_commands_submitted_total", "Writes merged into a light's pending command.", &DeviceMetrics::commands_submitted },
+    { "wled_commands_sent_total", "Commands sent to a light after coalescing.", &DeviceMetrics::commands_sent },
+    { "wled_commands_unconfirmed_total", "Commands a light never confirmed.", &DeviceMetrics::commands_unconfirmed },
+    { "wled_reconnect_attempts_total", "Attempts to reconnect to a light.", &DeviceMetrics::reconnect_attempts },
+};
+} // namespace
+
+void Histogram::record(uint64_t micros)
+{
+    buckets[bucket(micros)].fetch_add(1, std::memory_order_relaxed);
+    total.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(micros, std::memory_order_relaxed);
+}
+
+size_t Histogram::bucket(uint64_t micros)
+{
+    // Shifted down by one so each bucket ends on its edge() instead of starting there
+    uint64_t value = std::min<uint64_t>(micros == 0 ? 0 : micros - 1, (uint64_t{ 1 } << kMaxBits) - 1);
+    if (value < kSubBuckets)
+        return static_cast<size_t>(value);
+
+    unsigned msb   = 63u - static_cast<unsigned>(__builtin_clzll(value));
+    unsigned shift = msb - kSubBucketBits;
+    return (shift + 1) * kSubBuckets + static_cast<size_t>((value >> shift) - kSubBuckets);
+}
+
+uint64_t Histogram::edge(size_t index)
+{
+    if (index < kSubBuckets)
+        return index;
+
+    size_t shift = index / kSubBuckets - 1;
+    return uint64_t{ kSubBuckets + index % kSubBuckets } << shift;
+}
+
+uint64_t Histogram::count_at_most(uint64_t bound) const
+{
+    // Every bucket before the one `bound + 1` would land in ends at or below `bound`
+    size_t end = bound >= uint64_t{ 1 } << kMaxBits ? kBuckets : bucket(bound + 1);
+
+    uint64_t count = 0;
+    for (size_t i = 0; i < end; i++)
+        count += buckets[i].load(std::memory_order_relaxed);
+    return count;
+}
+
+uint64_t Histogram::percentile(double q) const
+{
+    std::array<uint64_t, kBuckets> counts;
+    uint64_t total_count = 0;
+    for (size_t i = 0; i < kBuckets; i++)
+    {
+        counts[i] = buckets[i].load(std::memory_order_relaxed);
+        total_count += counts[i];
+    }
+    if (total_count == 0)
+        return 0;
+
+    q           = std::clamp(q, 0.0, 1.0);
+    auto target = std::max<uint64_t>(1, static_cast<uint64_t>(q * static_cast<double>(total_count) + 0.5));
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets; i++)
+    {
+        seen += counts[i];
+        if (seen >= target)
+            return bucket_upper(i);
+    }
+    return bucket_upper(kBuckets - 1);
+}
+
+void Histogram::merge(const Histogram & other)
+{
+    for (size_t i = 0; i < kBuckets; i++)
+        buckets[i].fetch_add(other.buckets[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    total.fetch_add(other.count(), std::memory_order_relaxed);
+    sum_.fetch_add(other.sum(), std::memory_order_relaxed);
+}
+
+void MetricsRegistry::add(DeviceMetrics & metrics, std::string address, std::function<std::string()> name)
+{
+    std::lock_guard lock(mutex);
+    devices.push_back({ &metrics, std::move(address), std::move(name) });
+}
+
+void MetricsRegistry::remove(DeviceMetrics & metrics)
+{
+    std::lock_guard lock(mutex);
+    devices.erase(std::remove_if(devices.begin(), devices.end(), [&](const Entry & entry) { return entry.metrics == &metrics; }),
+                  devices.end());
+}
+
+void MetricsRegistry::render(std::string & out) const
+{
+    std::lock_guard lock(mutex);
+
+    std::vector<std::string> labels;
+    labels.reserve(devices.size());
+    for (const auto & entry : devices)
+    {
+        std::string label = "address=\"";
+        append_escaped(label, entry.address);
+        label += "\",name=\"";
+        append_escaped(label, entry.name());
+        label += '"';
+        labels.push_back(std::move(label));
+    }
+
+    std::string value;
+    for (const auto & family : kHistograms)
+    {
+        append_header(out, family.name, "histogram", family.help);
+        for (size_t i = 0; i < devices.size(); i++)
+            append_histogram(out, family.name, labels[i], devices[i].metrics->*family.histogram);
+    }
+
+    append_header(out, "wled_command_stage_seconds", "histogram",
+                  "Time confirmed commands spent in each stage between the Matter write and the light's confirmation.");
+    for (size_t i = 0; i < devices.size(); i++)
+    {
+        for (size_t stage = 0; stage < std::size(kStageNames); stage++)
+        {
+            std::string stage_labels = labels[i] + ",stage=\"" + kStageNames[stage] + '"';
+            append_histogram(out, "wled_command_stage_seconds", stage_labels, devices[i].metrics->stages[stage]);
+        }
+    }
+
+    for (const auto & family : kCounters)
+    {
+        append_header(out, family.name, "counter", family.help);
+        for (size_t i = 0; i < devices.size(); i++)
+        {
+            value.clear();
+            append_number(value, (devices[i].metrics->*family.counter).value());
+            append_sample(out, family.name, "", labels[i], {}, value);
+        }
+    }
+
+    uint64_t reachable = 0;
+    append_header(out, "wled_device_reachable", "gauge", "Whether the light is currently connected.");
+    for (size_t i = 0; i < devices.size(); i++)
+    {
+        bool up = devices[i].metrics->reachable.load(std::memory_order_relaxed);
+        reachable += up;
+        append_sample(out, "wled_device_reachable", "", labels[i], {}, up ? "1" : "0");
+    }
+
+    append_header(out, "wled_reachable_devices", "gauge", "Lights currently connected.");
+    value.clear();
+    append_number(value, reachable);
+    append_sample(out, "wled_reachable_devices", "", {}, {}, value);
+
+    append_header(out, "wled_devices", "gauge", "Lights known to the bridge.");
+    value.clear();
+    append_number(value, devices.size());
+    append_sample(out, "wled_devices", "", {}, {}, value);
+
+    append_header(out, "wled_report_backlog", "gauge", "Attribute changes waiting to be reported to Matter.");
+    value = std::to_string(report_backlog.value());
+    append_sample(out, "wled_report_backlog", "", {}, {}, value);
+
+    append_header(out, "wled_room_send_skew_seconds", "histogram",
+                  "Time between the first and the last light's command going out for one room action.");
+    append_histogram(out, "wled_room_send_skew_seconds", {}, room_send_skew);
+}
@@ -0,0 +1,125 @@
+#include <unistd.h>
+
+#include <algorithm>
+
+#include <lib/support/logging/CHIPLogging.h>
+
+#include "monitor.hpp"
+#include "trace.hpp"
+#include "wled.h"
+
+using namespace wled;
+
+Monitor::Monitor(Reactor & aReactor, TimerWheel & aTimers, int aPipeFd, LightSource aLights,
+                 std::chrono::milliseconds aKeepaliveBudget) :
+    reactor(aReactor),
+    timers(aTimers), pipe_fd(aPipeFd), lights(std::move(aLights)), keepalive_budget(aKeepaliveBudget)
+{}
+
+void Monitor::watch(int fd, std::function<void()> handler)
+{
+    watched.push_back({ fd, std::move(handler) });
+    reactor.add(fd, EPOLLIN, &watched.back());
+}
+
+void Monitor::stop()
+{
+    stopping = true;
+    reactor.wake();
+}
+
+// Only called when the monitor pipe is poked i.e. a device was added, removed, or reconnected
+void Monitor::sync_registrations()
+{
+    current.clear();
+    lights(current);
+
+    // Drop everything stale first, a closed descriptor's number may already belong to another light's new socket
+    for (auto it = registered.begin(); it != registered.end();)
+    {
+        WLED * light = it->first;
+        bool known   = std::find(current.begin(), current.end(), light) != current.end();
+
+        if (known && light->IsReachable() && it->second.fd == light->socket() && it->second.generation == light->generation())
+        {
+            ++it;
+            continue;
+        }
+
+        reactor.remove(it->second.fd);
+        light->DisarmKeepalive();
+        it = registered.erase(it);
+    }
+
+    for (auto light : current)
+    {
+        if (!light->IsReachable() || registered.count(light))
+            continue;
+
+        // Edge-triggered: update() always reads until the socket would block
+        if (reactor.add(light->socket(), EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET, light))
+        {
+            registered[light] = { light->socket(), light->generation() };
+            light->ArmKeepalive(timers, keepalive_budget);
+        }
+    }
+}
+
+void Monitor::run()
+{
+    constexpr int MAX_EVENTS = 32;
+    struct epoll_event events[MAX_EVENTS];
+
+    // The pipe and watched descriptors are identified by their address, everything else is a WLED
+    reactor.add(pipe_fd, EPOLLIN, &pipe_fd);
+    sync_registrations();
+
+    while (!stopping)
+    {
+        bool resync = false;
+        int timeout = timers.next_timeout(TimerWheel::Clock::now());
+        int ready   = reactor.wait(events, MAX_EVENTS, timeout);
+
+        for (int i = 0; i < ready; i++)
+        {
+            void * ctx = events[i].data.ptr;
+
+            if (ctx == &pipe_fd)
+            {
+                char buf[64];
+                // Don't care what it is, just breaking out of epoll_wait
+                if (read(pipe_fd, &buf, sizeof(buf)) < 0)
+                    ChipLogError(DeviceLayer, "Could not read from monitor pipe");
+                resync = true;
+                continue;
+            }
+
+            auto watch = std::find_if(watched.begin(), watched.end(), [ctx](const Watched & entry) { return &entry == ctx; });
+            if (watch != watched.end())
+            {
+                watch->handler();
+                resync = true;
+                continue;
+            }
+
+            auto light = static_cast<WLED *>(ctx);
+            // An earlier event in this batch may have disconnected it
+            if (!light->IsReachable())
+            {
+                resync = true;
+                continue;
+            }
+            trace::record(trace::Event::kReadyToUpdate, light->GetEndpointId(), events[i].events);
+            light->update(events[i].events);
+            if (!light->IsReachable())
+                resync = true;
+        }
+
+        timers.advance(TimerWheel::Clock::now());
+
+        if (resync)
+            sync_registrations();
+    }
+
+    reactor.remove(pipe_fd);
+}
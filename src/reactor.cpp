@@ -0,0 +1,104 @@
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "reactor.hpp"
+
+using namespace wled;
+
+Reactor::Reactor()
+{
+    epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd < 0)
+    {
+        std::cerr << "epoll_create1: " << strerror(errno) << std::endl;
+        abort();
+    }
+
+    wakefd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (wakefd < 0 || !add(wakefd, EPOLLIN, &wakefd))
+    {
+        std::cerr << "eventfd: " << strerror(errno) << std::endl;
+        abort();
+    }
+}
+
+Reactor::~Reactor()
+{
+    close(wakefd);
+    close(epfd);
+}
+
+bool Reactor::add(int fd, uint32_t events, void * context)
+{
+    struct epoll_event ev = {};
+    ev.events             = events;
+    ev.data.ptr           = context;
+
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) < 0)
+    {
+        std::cerr << "epoll_ctl(EPOLL_CTL_ADD): " << strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool Reactor::modify(int fd, uint32_t events, void * context)
+{
+    struct epoll_event ev = {};
+    ev.events             = events;
+    ev.data.ptr           = context;
+
+    if (epoll_ctl(epfd, EPOLL_CTL_MOD, fd, &ev) < 0)
+    {
+        std::cerr << "epoll_ctl(EPOLL_CTL_MOD): " << strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void Reactor::remove(int fd)
+{
+    // Closing a descriptor already drops it from the interest list, so ENOENT/EBADF are expected here
+    if (epoll_ctl(epfd, EPOLL_CTL_DEL, fd, nullptr) < 0 && errno != ENOENT && errno != EBADF)
+        std::cerr << "epoll_ctl(EPOLL_CTL_DEL): " << strerror(errno) << std::endl;
+}
+
+int Reactor::wait(struct epoll_event * events, int max_events, int timeout_ms)
+{
+    int ret;
+    do
+    {
+        ret = epoll_wait(epfd, events, max_events, timeout_ms);
+    } while (ret < 0 && errno == EINTR);
+
+    if (ret < 0)
+    {
+        std::cerr << "epoll_wait: " << strerror(errno) << std::endl;
+        abort();
+    }
+
+    // Swallow the wake-up event, callers only see their own descriptors
+    for (int i = 0; i < ret; i++)
+    {
+        if (events[i].data.ptr != &wakefd)
+            continue;
+
+        uint64_t count;
+        if (read(wakefd, &count, sizeof(count)) < 0 && errno != EAGAIN)
+            std::cerr << "read(eventfd): " << strerror(errno) << std::endl;
+        events[i] = events[--ret];
+        break;
+    }
+    return ret;
+}
+
+void Reactor::wake()
+{
+    uint64_t one = 1;
+    if (write(wakefd, &one, sizeof(one)) < 0 && errno != EAGAIN)
+        std::cerr << "write(eventfd): " << strerror(errno) << std::endl;
+}
@@ -0,0 +1,152 @@
+#include <algorithm>
+
+#include <lib/support/logging/CHIPLogging.h>
+
+#include "reconnect.hpp"
+
+using namespace wled;
+
+ReconnectManager::Target::Target() : timer(on_timer, this) {}
+
+ReconnectManager::Target::~Target()
+{
+    if (owner)
+        owner->cancel(*this);
+}
+
+void ReconnectManager::Target::on_timer(void * context)
+{
+    auto target = static_cast<Target *>(context);
+    target->owner->due(*target);
+}
+
+ReconnectManager::~ReconnectManager()
+{
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    ready_cv.notify_all();
+    for (auto & thread : workers)
+        thread.join();
+}
+
+void ReconnectManager::configure(const Config & aConfig)
+{
+    std::lock_guard lock(mutex);
+    config = aConfig;
+    if (config.max_attempts == 0)
+        config.max_attempts = 1;
+    if (config.max_backoff < config.initial_backoff)
+        config.max_backoff = config.initial_backoff;
+
+    while (workers.size() < config.max_attempts)
+        workers.emplace_back(&ReconnectManager::worker, this);
+}
+
+// Caller must hold the mutex
+void ReconnectManager::arm(Target & target, Clock::time_point now)
+{
+    // Equal jitter: half of the backoff is fixed, the other half random
+    auto half  = target.backoff.count() / 2;
+    auto delay = std::chrono::milliseconds(half + std::uniform_int_distribution<decltype(half)>(0, half)(rng));
+
+    target.state = Target::State::Waiting;
+    if (timers.schedule(target.timer, now + delay))
+        reactor.wake();
+}
+
+void ReconnectManager::schedule(Target & target)
+{
+    std::lock_guard lock(mutex);
+    if (target.state != Target::State::Idle)
+        return;
+
+    target.owner   = this;
+    target.backoff = config.initial_backoff;
+    pending_count++;
+    arm(target, Clock::now());
+}
+
+void ReconnectManager::start(Target & target)
+{
+    {
+        std::lock_guard lock(mutex);
+        if (target.state != Target::State::Idle)
+            return;
+
+        target.owner   = this;
+        target.backoff = config.initial_backoff;
+        target.state   = Target::State::Queued;
+        pending_count++;
+        ready.push_back(&target);
+    }
+    ready_cv.notify_one();
+}
+
+void ReconnectManager::cancel(Target & target)
+{
+    std::unique_lock lock(mutex);
+    attempt_done_cv.wait(lock, [&] { return target.state != Target::State::Attempting; });
+
+    if (target.state == Target::State::Idle)
+        return;
+
+    ready.erase(std::remove(ready.begin(), ready.end(), &target), ready.end());
+    target.state = Target::State::Idle;
+    pending_count--;
+    lock.unlock();
+
+    // A due() that is already running needs the mutex to see the target is idle, and cancel() waits for it
+    timers.cancel(target.timer);
+}
+
+void ReconnectManager::due(Target & target)
+{
+    {
+        std::lock_guard lock(mutex);
+        if (target.state != Target::State::Waiting)
+            return;
+        target.state = Target::State::Queued;
+        ready.push_back(&target);
+    }
+    ready_cv.notify_one();
+}
+
+void ReconnectManager::worker()
+{
+    std::unique_lock lock(mutex);
+    while (true)
+    {
+        ready_cv.wait(lock, [&] { return stopping || !ready.empty(); });
+        if (stopping)
+            return;
+
+        Target & target = *ready.front();
+        ready.pop_front();
+        target.state = Target::State::Attempting;
+
+        lock.unlock();
+        bool connected = target.reconnect_attempt();
+        lock.lock();
+
+        if (connected)
+        {
+            target.state = Target::State::Idle;
+            pending_count--;
+            succeeded_count++;
+            ChipLogProgress(DeviceLayer, "[%s] Reconnected (%u still pending)", target.reconnect_name(),
+                            static_cast<unsigned>(pending_count.load()));
+        }
+        else
+        {
+            failed_count++;
+            target.backoff = std::min(target.backoff * 2, config.max_backoff);
+            ChipLogError(DeviceLayer, "[%s] Could not reconnect, trying again in about %lld seconds (%u pending, %llu failed)",
+                         target.reconnect_name(), static_cast<long long>(target.backoff.count() / 1000),
+                         static_cast<unsigned>(pending_count.load()), static_cast<unsigned long long>(failed_count.load()));
+            arm(target, Clock::now());
+        }
+        attempt_done_cv.notify_all();
+    }
+}
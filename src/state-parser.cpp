@@ -0,0 +1,400 @@
+#include "state-parser.hpp"
+
+using namespace wled;
+
+bool StateParser::parse(std::string_view json, bool with_info, ParsedState & out)
+{
+    out.present = 0;
+    StateParser parser(json);
+    return parser.parse_root(with_info, out);
+}
+
+void StateParser::skip_whitespace()
+{
+    while (cur < end && (*cur == ' ' || *cur == '\n' || *cur == '\r' || *cur == '\t'))
+        cur++;
+}
+
+bool StateParser::expect(char c)
+{
+    skip_whitespace();
+    if (cur >= end || *cur != c)
+        return false;
+    cur++;
+    return true;
+}
+
+template <typename F>
+bool StateParser::for_each_member(F && on_member)
+{
+    if (!expect('{'))
+        return false;
+
+    bool first = true;
+    while (true)
+    {
+        skip_whitespace();
+        if (cur >= end)
+            return false;
+        if (*cur == '}')
+        {
+            cur++;
+            return true;
+        }
+        if (!first && !expect(','))
+            return false;
+        first = false;
+
+        // Keys in WLED documents never contain escapes, take them as-is
+        if (!expect('"'))
+            return false;
+        const char * start = cur;
+        while (cur < end && *cur != '"')
+            cur++;
+        if (cur >= end)
+            return false;
+        std::string_view key(start, static_cast<size_t>(cur - start));
+        cur++;
+
+        if (!expect(':') || !on_member(key))
+            return false;
+    }
+}
+
+template <typename F>
+bool StateParser::for_each_element(F && on_element)
+{
+    if (!expect('['))
+        return false;
+
+    size_t index = 0;
+    while (true)
+    {
+        skip_whitespace();
+        if (cur >= end)
+            return false;
+        if (*cur == ']')
+        {
+            cur++;
+            return true;
+        }
+        if (index > 0 && !expect(','))
+            return false;
+
+        if (!on_element(index++))
+            return false;
+    }
+}
+
+bool StateParser::find_member(std::string_view json, std::string_view key, std::string_view & value)
+{
+    StateParser parser(json);
+    bool found = false;
+
+    bool ok = parser.for_each_member([&](std::string_view member) {
+        if (found || member != key)
+            return parser.skip_value();
+
+        parser.skip_whitespace();
+        const char * start = parser.cur;
+        if (!parser.skip_value())
+            return false;
+        value = std::string_view(start, static_cast<size_t>(parser.cur - start));
+        found = true;
+        return true;
+    });
+
+    return ok && found;
+}
+
+bool StateParser::parse_root(bool with_info, ParsedState & out)
+{
+    return for_each_member([&](std::string_view key) {
+        if (key == "state")
+            return parse_state(out);
+        if (key == "info" && with_info)
+            return parse_info(out);
+        return skip_value();
+    });
+}
+
+bool StateParser::parse_state(ParsedState & out)
+{
+    return for_each_member([&](std::string_view key) {
+        if (key == "on")
+        {
+            if (!parse_bool(out.on))
+                return false;
+            out.present |= ParsedState::kOn;
+            return true;
+        }
+        if (key == "bri")
+        {
+            uint32_t bri;
+            if (!parse_uint(bri))
+                return false;
+            out.brightness = static_cast<uint8_t>(bri > 255 ? 255 : bri);
+            out.present |= ParsedState::kBrightness;
+            return true;
+        }
+        if (key == "transition")
+        {
+            uint32_t transition;
+            if (!parse_uint(transition))
+                return false;
+            out.transition = static_cast<uint16_t>(transition > UINT16_MAX ? UINT16_MAX : transition);
+            out.present |= ParsedState::kTransition;
+            return true;
+        }
+        if (key == "seg")
+            return parse_segments(out);
+        return skip_value();
+    });
+}
+
+bool StateParser::parse_segments(ParsedState & out)
+{
+    skip_whitespace();
+    // A single segment may be sent as an object rather than an array
+    if (cur < end && *cur == '{')
+        return parse_segment(out);
+
+    return for_each_element([&](size_t index) { return index == 0 ? parse_segment(out) : skip_value(); });
+}
+
+bool StateParser::parse_segment(ParsedState & out)
+{
+    return for_each_member([&](std::string_view key) {
+        if (key == "col")
+        {
+            return for_each_element([&](size_t index) { return index == 0 ? parse_color(out) : skip_value(); });
+        }
+        if (key == "cct")
+        {
+            uint32_t cct;
+            if (!parse_uint(cct))
+                return false;
+            out.cct = static_cast<uint16_t>(cct > 0xFFFF ? 0xFFFF : cct);
+            out.present |= ParsedState::kCct;
+            return true;
+        }
+        return skip_value();
+    });
+}
+
+bool StateParser::parse_color(ParsedState & out)
+{
+    out.color_count = 0;
+    bool ok         = for_each_element([&](size_t index) {
+        uint32_t channel;
+        if (index >= sizeof(out.color) || !parse_uint(channel))
+            return skip_value();
+        out.color[index] = static_cast<uint8_t>(channel > 255 ? 255 : channel);
+        out.color_count  = static_cast<uint8_t>(index + 1);
+        return true;
+    });
+    if (ok)
+        out.present |= ParsedState::kColor;
+    return ok;
+}
+
+bool StateParser::parse_info(ParsedState & out)
+{
+    return for_each_member([&](std::string_view key) {
+        if (key == "name")
+        {
+            out.present |= ParsedState::kName;
+            return parse_string(out.name, sizeof(out.name));
+        }
+        if (key == "mac")
+        {
+            out.present |= ParsedState::kMac;
+            return parse_string(out.mac, sizeof(out.mac));
+        }
+        if (key == "arch")
+        {
+            out.present |= ParsedState::kArch;
+            return parse_string(out.arch, sizeof(out.arch));
+        }
+        if (key == "ver")
+        {
+            out.present |= ParsedState::kVersion;
+            return parse_string(out.version, sizeof(out.version));
+        }
+        if (key == "leds")
+            return parse_leds(out);
+        return skip_value();
+    });
+}
+
+bool StateParser::parse_leds(ParsedState & out)
+{
+    return for_each_member([&](std::string_view key) {
+        if (key == "lc")
+        {
+            uint32_t lc;
+            if (!parse_uint(lc))
+                return false;
+            out.capabilities = static_cast<int>(lc & 0xFF);
+            out.present |= ParsedState::kCapabilities;
+            return true;
+        }
+        return skip_value();
+    });
+}
+
+bool StateParser::parse_bool(bool & value)
+{
+    skip_whitespace();
+    if (end - cur >= 4 && std::string_view(cur, 4) == "true")
+    {
+        value = true;
+        cur += 4;
+        return true;
+    }
+    if (end - cur >= 5 && std::string_view(cur, 5) == "false")
+    {
+        value = false;
+        cur += 5;
+        return true;
+    }
+    return false;
+}
+
+// Negative and fractional parts are clamped/truncated, none of the fields we read use them
+bool StateParser::parse_uint(uint32_t & value)
+{
+    skip_whitespace();
+    bool negative = cur < end && *cur == '-';
+    if (negative)
+        cur++;
+
+    if (cur >= end || *cur < '0' || *cur > '9')
+        return false;
+
+    uint64_t result = 0;
+    while (cur < end && *cur >= '0' && *cur <= '9')
+    {
+        if (result <= 0xFFFFFFFF)
+            result = result * 10 + static_cast<uint64_t>(*cur - '0');
+        cur++;
+    }
+    while (cur < end && ((*cur >= '0' && *cur <= '9') || *cur == '.' || *cur == 'e' || *cur == 'E' || *cur == '+' ||
+                         *cur == '-'))
+        cur++;
+
+    value = negative ? 0 : static_cast<uint32_t>(result > 0xFFFFFFFF ? 0xFFFFFFFF : result);
+    return true;
+}
+
+// Copies a string value, truncating to `size - 1`. Escapes other than \uXXXX are decoded, \uXXXX becomes '?'.
+bool StateParser::parse_string(char * buffer, size_t size)
+{
+    if (!expect('"'))
+        return false;
+
+    size_t length = 0;
+    while (cur < end && *cur != '"')
+    {
+        char c = *cur++;
+        if (c == '\\')
+        {
+            if (cur >= end)
+                return false;
+            c = *cur++;
+            switch (c)
+            {
+            case 'n':
+                c = '\n';
+                break;
+            case 't':
+                c = '\t';
+                break;
+            case 'r':
+                c = '\r';
+                break;
+            case 'b':
+                c = '\b';
+                break;
+            case 'f':
+                c = '\f';
+                break;
+            case 'u':
+                if (end - cur < 4)
+                    return false;
+                cur += 4;
+                c = '?';
+                break;
+            default:
+                break;
+            }
+        }
+        if (length + 1 < size)
+            buffer[length++] = c;
+    }
+    if (cur >= end)
+        return false;
+    cur++;
+
+    buffer[length] = '\0';
+    return true;
+}
+
+bool StateParser::skip_string()
+{
+    // Cursor is just past the opening quote
+    while (cur < end)
+    {
+        char c = *cur++;
+        if (c == '\\')
+            cur++;
+        else if (c == '"')
+            return cur <= end;
+    }
+    return false;
+}
+
+bool StateParser::skip_value()
+{
+    skip_whitespace();
+    if (cur >= end)
+        return false;
+
+    char c = *cur;
+    if (c == '"')
+    {
+        cur++;
+        return skip_string();
+    }
+
+    if (c == '{' || c == '[')
+    {
+        // Nesting doesn't need to be matched by type, only balanced, the document was produced by WLED
+        int depth = 0;
+        while (cur < end)
+        {
+            c = *cur++;
+            if (c == '"')
+            {
+                if (!skip_string())
+                    return false;
+            }
+            else if (c == '{' || c == '[')
+            {
+                depth++;
+            }
+            else if (c == '}' || c == ']')
+            {
+                if (--depth == 0)
+                    return true;
+            }
+        }
+        return false;
+    }
+
+    // Number or literal, runs until the next delimiter
+    while (cur < end && *cur != ',' && *cur != '}' && *cur != ']' && *cur != ' ' && *cur != '\n' && *cur != '\r' &&
+           *cur != '\t')
+        cur++;
+    return true;
+}
@@ -0,0 +1,190 @@
+#include <algorithm>
+
+#include "timer-wheel.hpp"
+
+using namespace wled;
+
+TimerWheel::TimerWheel() : origin(Clock::now()) {}
+
+uint64_t TimerWheel::to_tick(Clock::time_point when) const
+{
+    if (when <= origin)
+        return 0;
+    // Round up so a timer never fires early
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(when - origin).count();
+    return static_cast<uint64_t>((elapsed + kTick.count() - 1) / kTick.count());
+}
+
+void TimerWheel::link(Timer & timer)
+{
+    Timer *& head = slots[timer.expires % kSlots];
+    timer.prev    = nullptr;
+    timer.next    = head;
+    if (head)
+        head->prev = &timer;
+    head        = &timer;
+    timer.state = Timer::State::kArmed;
+    armed++;
+}
+
+void TimerWheel::unlink(Timer & timer)
+{
+    if (timer.prev)
+        timer.prev->next = timer.next;
+    else
+        slots[timer.expires % kSlots] = timer.next;
+    if (timer.next)
+        timer.next->prev = timer.prev;
+    timer.next = timer.prev = nullptr;
+    timer.state             = Timer::State::kIdle;
+    armed--;
+}
+
+void TimerWheel::queue(Timer & timer)
+{
+    timer.next = nullptr;
+    timer.prev = fired_tail;
+    if (fired_tail)
+        fired_tail->next = &timer;
+    else
+        fired_head = &timer;
+    fired_tail  = &timer;
+    timer.state = Timer::State::kFired;
+}
+
+void TimerWheel::dequeue(Timer & timer)
+{
+    if (timer.prev)
+        timer.prev->next = timer.next;
+    else
+        fired_head = timer.next;
+    if (timer.next)
+        timer.next->prev = timer.prev;
+    else
+        fired_tail = timer.prev;
+    timer.next = timer.prev = nullptr;
+    timer.state             = Timer::State::kIdle;
+}
+
+// Takes `timer` off whichever list it is on, the mutex must be held
+void TimerWheel::detach(Timer & timer)
+{
+    if (timer.state == Timer::State::kArmed)
+        unlink(timer);
+    else if (timer.state == Timer::State::kFired)
+        dequeue(timer);
+}
+
+bool TimerWheel::schedule(Timer & timer, Clock::time_point when)
+{
+    std::lock_guard lock(mutex);
+
+    // A timer that is due but hasn't fired yet fires at the new time instead
+    detach(timer);
+
+    uint64_t previous_earliest = armed ? earliest_tick() : UINT64_MAX;
+    timer.expires              = std::max(to_tick(when), current_tick);
+    link(timer);
+
+    return timer.expires < previous_earliest;
+}
+
+void TimerWheel::cancel(Timer & timer)
+{
+    std::unique_lock lock(mutex);
+    detach(timer);
+
+    // A callback cancelling its own timer would wait for itself
+    if (std::this_thread::get_id() == advancing)
+        return;
+
+    fired_cv.wait(lock, [&] { return firing != &timer; });
+    // The callback may have re-armed its own timer while we waited
+    detach(timer);
+}
+
+bool TimerWheel::is_scheduled(const Timer & timer)
+{
+    std::lock_guard lock(mutex);
+    return timer.state != Timer::State::kIdle;
+}
+
+// Only looks one revolution ahead; a timer further out than that just causes a harmless early wake-up
+uint64_t TimerWheel::earliest_tick() const
+{
+    for (uint64_t tick = current_tick; tick < current_tick + kSlots; tick++)
+    {
+        uint64_t earliest = UINT64_MAX;
+        for (Timer * timer = slots[tick % kSlots]; timer; timer = timer->next)
+            earliest = std::min(earliest, timer->expires);
+        if (earliest == tick)
+            return tick;
+        if (earliest != UINT64_MAX && earliest < tick + kSlots)
+            return std::max(earliest, tick);
+    }
+    return current_tick + kSlots;
+}
+
+int TimerWheel::next_timeout(Clock::time_point now)
+{
+    std::lock_guard lock(mutex);
+    if (!armed)
+        return -1;
+
+    auto due = origin + earliest_tick() * kTick;
+    if (due <= now)
+        return 0;
+    return static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(due - now).count());
+}
+
+void TimerWheel::advance(Clock::time_point now)
+{
+    std::unique_lock lock(mutex);
+
+    uint64_t target = to_tick(now);
+    // to_tick() rounds up, only ticks that are fully in the past are due
+    if (origin + target * kTick > now && target > 0)
+        target--;
+
+    // Past one revolution every slot gets visited anyway
+    uint64_t first = current_tick;
+    if (target >= first + kSlots)
+        first = target - kSlots + 1;
+
+    for (uint64_t tick = first; tick <= target && armed; tick++)
+    {
+        Timer * timer = slots[tick % kSlots];
+        while (timer)
+        {
+            Timer * next = timer->next;
+            if (timer->expires <= target)
+            {
+                unlink(*timer);
+                queue(*timer);
+            }
+            timer = next;
+        }
+    }
+
+    current_tick = std::max(current_tick, target + 1);
+
+    // One at a time, anything rescheduled or cancelled while an earlier callback ran has already left the list
+    advancing = std::this_thread::get_id();
+    while (fired_head)
+    {
+        Timer * timer = fired_head;
+        dequeue(*timer);
+        firing        = timer;
+        auto callback = timer->callback;
+        auto context  = timer->context;
+
+        lock.unlock();
+        if (callback)
+            callback(context);
+        lock.lock();
+
+        firing = nullptr;
+        fired_cv.notify_all();
+    }
+    advancing = {};
+}
@@ -0,0 +1,289 @@
+#include <signal.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <array>
+#include <atomic>
+
+#include "trace.hpp"
+
+using namespace wled;
+using namespace wled::trace;
+
+namespace {
+static_assert((kRecordsPerThread & (kRecordsPerThread - 1)) == 0, "Trace ring size must be a power of two");
+
+// Words are atomics so a dump racing the owning thread reads stale or torn records instead of undefined behavior. Torn
+// ones are recognized afterwards by the ring having moved past them.
+struct Slot
+{
+    std::atomic<uint64_t> timestamp;
+    // event | a << 16
+    std::atomic<uint64_t> header;
+    std::atomic<uint64_t> b;
+    std::atomic<const char *> name;
+};
+
+struct Ring
+{
+    std::atomic<bool> claimed{ false };
+    // Only ever written by the claiming thread
+    alignas(64) std::atomic<uint64_t> head{ 0 };
+    std::array<Slot, kRecordsPerThread> slots;
+};
+
+// Static so recording never allocates and a crash dump doesn't depend on the heap
+std::array<Ring, kMaxThreads> gRings;
+std::atomic<size_t> gDropped{ 0 };
+
+// A thread gives its ring back when it exits. The records stay, the next thread to claim it continues after them.
+struct Owner
+{
+    Ring * ring    = nullptr;
+    bool exhausted = false;
+
+    ~Owner()
+    {
+        if (ring)
+            ring->claimed.store(false, std::memory_order_release);
+    }
+
+    Ring * get()
+    {
+        if (ring || exhausted)
+            return ring;
+
+        for (auto & candidate : gRings)
+        {
+            bool expected = false;
+            if (candidate.claimed.compare_exchange_strong(expected, true, std::memory_order_acquire))
+            {
+                ring = &candidate;
+                return ring;
+            }
+        }
+        exhausted = true;
+        return nullptr;
+    }
+};
+
+thread_local Owner tOwner;
+
+uint64_t now_ns()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000u + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+void append(Ring & ring, Event event, uint32_t a, uint64_t b, const char * name)
+{
+    uint64_t index = ring.head.load(std::memory_order_relaxed);
+    Slot & slot    = ring.slots[index & (kRecordsPerThread - 1)];
+    slot.timestamp.store(now_ns(), std::memory_order_relaxed);
+    slot.header.store(static_cast<uint64_t>(event) | uint64_t{ a } << 16, std::memory_order_relaxed);
+    slot.b.store(b, std::memory_order_relaxed);
+    slot.name.store(name, std::memory_order_relaxed);
+    ring.head.store(index + 1, std::memory_order_release);
+}
+
+// Formatting without stdio, everything here has to be safe inside a signal handler
+class Writer
+{
+public:
+    explicit Writer(int aFd) : fd(aFd) {}
+    ~Writer() { flush(); }
+
+    Writer(const Writer &)              = delete;
+    Writer & operator=(const Writer &)  = delete;
+    Writer(Writer && other)             = delete;
+    Writer & operator=(Writer && other) = delete;
+
+    Writer & text(const char * s)
+    {
+        while (s && *s)
+            put(*s++);
+        return *this;
+    }
+
+    Writer & number(uint64_t value, unsigned min_digits = 1)
+    {
+        char digits[20];
+        unsigned count = 0;
+        do
+        {
+            digits[count++] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value);
+        for (; count < min_digits; ++count)
+            digits[count] = '0';
+        while (count)
+            put(digits[--count]);
+        return *this;
+    }
+
+    Writer & hex(uint64_t value)
+    {
+        text("0x");
+        bool leading = true;
+        for (int shift = 60; shift >= 0; shift -= 4)
+        {
+            unsigned nibble = static_cast<unsigned>(value >> shift) & 0xf;
+            if (leading && nibble == 0 && shift)
+                continue;
+            leading = false;
+            put("0123456789abcdef"[nibble]);
+        }
+        return *this;
+    }
+
+    void flush()
+    {
+        size_t written = 0;
+        while (written < length)
+        {
+            ssize_t result = ::write(fd, buffer + written, length - written);
+            if (result <= 0)
+                break;
+            written += static_cast<size_t>(result);
+        }
+        length = 0;
+    }
+
+private:
+    void put(char c)
+    {
+        if (length == sizeof(buffer))
+            flush();
+        buffer[length++] = c;
+    }
+
+    int fd;
+    char buffer[512];
+    size_t length = 0;
+};
+
+uint8_t byte(uint64_t value, unsigned index)
+{
+    return static_cast<uint8_t>(value >> (index * 8));
+}
+
+void format(Writer & out, uint64_t timestamp, Event event, uint32_t a, uint64_t b, const char * name)
+{
+    out.number(timestamp / 1000000000u).text(".").number(timestamp / 1000u % 1000000u, 6).text(" ");
+
+    switch (event)
+    {
+    case Event::kThreadStart:
+        out.text("thread ").number(a);
+        break;
+    case Event::kSend:
+        out.text("send ").text(name).text(" ep=").number(a & 0xffff).text(" fields=").hex(byte(b, 0));
+        out.text(" on=").number(byte(b, 1)).text(" bri=").number(byte(b, 2));
+        out.text(" col=").number(byte(b, 3)).text(",").number(byte(b, 4)).text(",").number(byte(b, 5)).text(",");
+        out.number(byte(b, 6)).text(" cct=").number(byte(b, 7)).text(" tt=").number(a >> 16);
+        break;
+    case Event::kAttributeRead:
+        out.text("read ").text(name).text(" ep=").number(a).text(" value=").number(b);
+        break;
+    case Event::kAttributeWrite:
+        out.text("write ").text(name).text(" ep=").number(a).text(" value=").number(b);
+        break;
+    case Event::kReadyToUpdate:
+        out.text("ready ep=").number(a).text(" events=").hex(b);
+        break;
+    case Event::kCommandConfirmed: {
+        constexpr uint64_t mask = (uint64_t{ 1 } << kStageBits) - 1;
+        out.text("confirmed ep=").number(a).text(" coalesce_us=").number(b & mask);
+        out.text(" send_us=").number(b >> kStageBits & mask).text(" device_us=").number(b >> (2 * kStageBits) & mask);
+        break;
+    }
+    default:
+        out.text("event ").number(static_cast<uint64_t>(event)).text(" a=").number(a).text(" b=").number(b);
+        break;
+    }
+    out.text("\n");
+}
+
+void dump_ring(Writer & out, size_t index, const Ring & ring)
+{
+    uint64_t head = ring.head.load(std::memory_order_acquire);
+    if (head == 0)
+        return;
+
+    out.text("--- ring ").number(index).text(", ").number(head).text(" records\n");
+
+    uint64_t first = head > kRecordsPerThread ? head - kRecordsPerThread : 0;
+    for (uint64_t i = first; i < head; ++i)
+    {
+        const Slot & slot  = ring.slots[i & (kRecordsPerThread - 1)];
+        uint64_t timestamp = slot.timestamp.load(std::memory_order_relaxed);
+        uint64_t header    = slot.header.load(std::memory_order_relaxed);
+        uint64_t b         = slot.b.load(std::memory_order_relaxed);
+        const char * name  = slot.name.load(std::memory_order_relaxed);
+
+        // The owner writes record `head` into this slot next, so a slot is only intact while it's less than a full lap
+        // behind. Anything older was (being) overwritten while it was read.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (i + kRecordsPerThread <= ring.head.load(std::memory_order_relaxed))
+            continue;
+
+        format(out, timestamp, static_cast<Event>(header & 0xffff), static_cast<uint32_t>(header >> 16), b, name);
+    }
+}
+
+void on_fatal_signal(int signal)
+{
+    {
+        Writer out(STDERR_FILENO);
+        out.text("\n=== wled-matter-bridge caught signal ").number(static_cast<uint64_t>(signal)).text(", trace follows\n");
+    }
+    dump(STDERR_FILENO);
+
+    // SA_RESETHAND restored the default action, let it run
+    raise(signal);
+}
+} // namespace
+
+void trace::record(Event event, uint32_t a, uint64_t b, const char * name)
+{
+    bool first  = tOwner.ring == nullptr;
+    Ring * ring = tOwner.get();
+    if (!ring)
+    {
+        gDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    if (first)
+        append(*ring, Event::kThreadStart, static_cast<uint32_t>(syscall(SYS_gettid)), 0, nullptr);
+    append(*ring, event, a, b, name);
+}
+
+void trace::dump(int fd)
+{
+    Writer out(fd);
+    for (size_t i = 0; i < gRings.size(); ++i)
+        dump_ring(out, i, gRings[i]);
+
+    size_t lost = gDropped.load(std::memory_order_relaxed);
+    if (lost)
+        out.text("--- ").number(lost).text(" records dropped, too many threads\n");
+}
+
+void trace::install_crash_handler()
+{
+    struct sigaction action = {};
+    action.sa_handler       = on_fatal_signal;
+    action.sa_flags         = SA_RESETHAND;
+    sigemptyset(&action.sa_mask);
+
+    for (int signal : { SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT })
+        sigaction(signal, &action, nullptr);
+}
+
+size_t trace::dropped()
+{
+    return gDropped.load(std::memory_order_relaxed);
+}
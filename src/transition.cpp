@@ -0,0 +1,35 @@
+#include <algorithm>
+
+#include "transition.hpp"
+
+using namespace wled;
+
+void Transition::start(int32_t aFrom, int32_t aTo, std::chrono::milliseconds duration, Clock::time_point now)
+{
+    from    = aFrom;
+    to      = aTo;
+    begin   = now;
+    end     = now + duration;
+    running = true;
+}
+
+int32_t Transition::value(Clock::time_point now) const
+{
+    if (!active(now))
+        return to;
+    if (now <= begin)
+        return from;
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - begin).count();
+    auto total   = std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count();
+    return from + static_cast<int32_t>((static_cast<int64_t>(to - from) * elapsed) / total);
+}
+
+uint16_t Transition::remaining(Clock::time_point now) const
+{
+    if (!active(now))
+        return 0;
+
+    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(end - now).count();
+    return static_cast<uint16_t>(std::min<int64_t>((left + 99) / 100, UINT16_MAX));
+}
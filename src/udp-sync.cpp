@@ -0,0 +1,113 @@
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "udp-sync.hpp"
+
+using namespace wled;
+
+namespace {
+// Offsets into a WLED notifier packet
+constexpr size_t kPurpose        = 0;
+constexpr size_t kCallMode       = 1;
+constexpr size_t kBrightness     = 2;
+constexpr size_t kPrimaryRgb     = 3;
+constexpr size_t kPrimaryWhite   = 10;
+constexpr size_t kVersion        = 11;
+constexpr size_t kTransitionLow  = 17;
+constexpr size_t kTransitionHigh = 18;
+constexpr size_t kSyncGroups     = 36;
+constexpr size_t kNoCct          = 37;
+
+// Notifier packet (not WARLS), sent as a direct change
+constexpr uint8_t kNotifier     = 0;
+constexpr uint8_t kDirectChange = 1;
+// Has sync groups but no CCT or per-segment data
+constexpr uint8_t kPacketVersion = 9;
+constexpr uint8_t kAllGroups     = 0xff;
+} // namespace
+
+UdpSync::~UdpSync()
+{
+    close();
+}
+
+int UdpSync::open(const std::string & host, uint16_t port)
+{
+    close();
+
+    struct addrinfo hints = {};
+    hints.ai_family       = AF_UNSPEC;
+    hints.ai_socktype     = SOCK_DGRAM;
+
+    struct addrinfo * result;
+    std::string service = std::to_string(port);
+    int res             = getaddrinfo(host.c_str(), service.c_str(), &hints, &result);
+    if (res)
+    {
+        std::cerr << "getaddrinfo(" << host << "): " << gai_strerror(res) << std::endl;
+        return -1;
+    }
+
+    for (auto rp = result; rp != nullptr; rp = rp->ai_next)
+    {
+        sockfd = socket(rp->ai_family, rp->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, rp->ai_protocol);
+        if (sockfd < 0)
+            continue;
+        // Connected so every send() goes to the light without re-resolving
+        if (::connect(sockfd, rp->ai_addr, rp->ai_addrlen) == 0)
+            break;
+        ::close(sockfd);
+        sockfd = -1;
+    }
+    freeaddrinfo(result);
+
+    if (sockfd < 0)
+    {
+        std::cerr << "Could not open UDP socket to " << host << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+void UdpSync::close()
+{
+    if (sockfd >= 0)
+        ::close(sockfd);
+    sockfd = -1;
+}
+
+int UdpSync::send_state(uint8_t brightness, const uint8_t color[4], uint16_t transition_ms)
+{
+    if (sockfd < 0)
+        return -1;
+
+    memset(packet, 0, sizeof(packet));
+    packet[kPurpose]    = kNotifier;
+    packet[kCallMode]   = kDirectChange;
+    packet[kBrightness] = brightness;
+    memcpy(&packet[kPrimaryRgb], color, 3);
+    packet[kPrimaryWhite]   = color[3];
+    packet[kVersion]        = kPacketVersion;
+    packet[kTransitionLow]  = static_cast<uint8_t>(transition_ms & 0xff);
+    packet[kTransitionHigh] = static_cast<uint8_t>(transition_ms >> 8);
+    packet[kSyncGroups]     = kAllGroups;
+    packet[kNoCct]          = 0xff;
+
+    // ECONNREFUSED is an ICMP error left over from an earlier datagram, it says nothing about this one
+    ssize_t sent;
+    do
+    {
+        sent = ::send(sockfd, packet, sizeof(packet), MSG_NOSIGNAL);
+    } while (sent < 0 && (errno == EINTR || errno == ECONNREFUSED));
+
+    if (sent != static_cast<ssize_t>(sizeof(packet)))
+    {
+        std::cerr << "UDP send: " << strerror(errno) << std::endl;
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,493 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <random>
+#include <strings.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <crypto/CHIPCryptoPAL.h>
+#include <lib/support/Base64.h>
+
+#include "websocket.hpp"
+
+using namespace wled;
+
+namespace {
+constexpr uint8_t OPCODE_CONTINUATION = 0x0;
+constexpr uint8_t OPCODE_TEXT         = 0x1;
+constexpr uint8_t OPCODE_BINARY       = 0x2;
+constexpr uint8_t OPCODE_CLOSE        = 0x8;
+constexpr uint8_t OPCODE_PING         = 0x9;
+constexpr uint8_t OPCODE_PONG         = 0xA;
+
+constexpr uint8_t FLAG_FIN  = 0x80;
+constexpr uint8_t FLAG_MASK = 0x80;
+
+// Largest possible frame header: 2 bytes + 8 byte extended length + 4 byte mask
+constexpr size_t MAX_HEADER_BYTES = 14;
+// Control frames can't carry more than this
+constexpr size_t MAX_CONTROL_BYTES = 125;
+
+constexpr const char * WEBSOCKET_GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+std::string compute_accept(const std::string & key)
+{
+    std::string concatenated = key + WEBSOCKET_GUID;
+    uint8_t digest[chip::Crypto::kSHA1_Hash_Length];
+
+    if (chip::Crypto::Hash_SHA1(reinterpret_cast<const uint8_t *>(concatenated.data()), concatenated.size(), digest) !=
+        CHIP_NO_ERROR)
+        return "";
+
+    char encoded[BASE64_ENCODED_LEN(sizeof(digest)) + 1]{};
+    uint16_t length = chip::Base64Encode(digest, sizeof(digest), encoded);
+    return std::string(encoded, length);
+}
+
+const char * find_header(std::string_view headers, std::string_view name)
+{
+    size_t pos = 0;
+    while ((pos = headers.find("\r\n", pos)) != std::string_view::npos)
+    {
+        pos += 2;
+        if (headers.size() - pos > name.size() && strncasecmp(headers.data() + pos, name.data(), name.size()) == 0 &&
+            headers[pos + name.size()] == ':')
+        {
+            pos += name.size() + 1;
+            while (pos < headers.size() && headers[pos] == ' ')
+                pos++;
+            return headers.data() + pos;
+        }
+    }
+    return nullptr;
+}
+} // anonymous namespace
+
+WebSocket::WebSocket(size_t max_message_bytes) : max_message(max_message_bytes)
+{
+    inbuf.resize(max_message + MAX_HEADER_BYTES);
+    outbuf.reserve(1024);
+}
+
+WebSocket::~WebSocket()
+{
+    close();
+}
+
+int WebSocket::connect(const std::string & host, uint16_t port, const std::string & path)
+{
+    close();
+
+    struct addrinfo hints = {};
+    hints.ai_family       = AF_UNSPEC;
+    hints.ai_socktype     = SOCK_STREAM;
+    hints.ai_flags        = AI_NUMERICSERV;
+
+    struct addrinfo * result = nullptr;
+    std::string service      = std::to_string(port);
+    int ret                  = getaddrinfo(host.c_str(), service.c_str(), &hints, &result);
+    if (ret != 0)
+    {
+        std::cerr << "getaddrinfo(" << host << "): " << gai_strerror(ret) << std::endl;
+        return -1;
+    }
+
+    sockfd = ::socket(result->ai_family, result->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, result->ai_protocol);
+    if (sockfd < 0)
+    {
+        std::cerr << "socket: " << strerror(errno) << std::endl;
+        freeaddrinfo(result);
+        return -1;
+    }
+
+    // Commands are tiny and latency sensitive
+    int one = 1;
+    setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    ret = ::connect(sockfd, result->ai_addr, result->ai_addrlen);
+    freeaddrinfo(result);
+    if (ret < 0 && errno != EINPROGRESS)
+    {
+        std::cerr << "connect(" << host << "): " << strerror(errno) << std::endl;
+        return fail();
+    }
+
+    std::random_device rd;
+    uint8_t nonce[16];
+    for (auto & byte : nonce)
+        byte = static_cast<uint8_t>(rd());
+    mask_state = rd() | 1;
+
+    char key[BASE64_ENCODED_LEN(sizeof(nonce)) + 1]{};
+    chip::Base64Encode(nonce, sizeof(nonce), key);
+    expected_accept = compute_accept(key);
+    request_host    = host;
+    request_path    = path;
+
+    std::string request = "GET " + path + " HTTP/1.1\r\n" + "Host: " + host + ":" + service + "\r\n" +
+        "Upgrade: websocket\r\n"
+        "Connection: Upgrade\r\n"
+        "Sec-WebSocket-Key: " +
+        key +
+        "\r\n"
+        "Sec-WebSocket-Version: 13\r\n"
+        "\r\n";
+    outbuf.assign(request.begin(), request.end());
+    opos = 0;
+
+    rpos = wpos = 0;
+    fragmenting = false;
+    fragments.clear();
+    assembled.clear();
+
+    current_state = State::Connecting;
+    last_receive  = std::chrono::steady_clock::now();
+    return 0;
+}
+
+void WebSocket::close()
+{
+    if (sockfd < 0)
+        return;
+
+    if (current_state == State::Open)
+    {
+        // Best effort, the peer may already be gone
+        uint8_t frame[6] = { FLAG_FIN | OPCODE_CLOSE, FLAG_MASK, 0, 0, 0, 0 };
+        (void) ::send(sockfd, frame, sizeof(frame), MSG_NOSIGNAL);
+    }
+
+    ::close(sockfd);
+    sockfd        = -1;
+    current_state = State::Closed;
+    outbuf.clear();
+    opos = 0;
+}
+
+int WebSocket::fail()
+{
+    if (sockfd >= 0)
+        ::close(sockfd);
+    sockfd        = -1;
+    current_state = State::Closed;
+    outbuf.clear();
+    opos = 0;
+    return -1;
+}
+
+int WebSocket::on_writable()
+{
+    if (current_state == State::Closed)
+        return -1;
+
+    if (current_state == State::Connecting)
+    {
+        int error        = 0;
+        socklen_t length = sizeof(error);
+        if (getsockopt(sockfd, SOL_SOCKET, SO_ERROR, &error, &length) < 0 || error != 0)
+        {
+            std::cerr << "connect(" << request_host << "): " << strerror(error ? error : errno) << std::endl;
+            return fail();
+        }
+        current_state = State::Handshaking;
+    }
+
+    return flush();
+}
+
+int WebSocket::flush()
+{
+    while (opos < outbuf.size())
+    {
+        ssize_t sent = ::send(sockfd, outbuf.data() + opos, outbuf.size() - opos, MSG_NOSIGNAL);
+        if (sent < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return 0;
+            if (errno == EINTR)
+                continue;
+            std::cerr << "send(" << request_host << "): " << strerror(errno) << std::endl;
+            return fail();
+        }
+        opos += static_cast<size_t>(sent);
+    }
+
+    outbuf.clear();
+    opos = 0;
+    return 0;
+}
+
+int WebSocket::on_readable()
+{
+    if (current_state == State::Closed)
+        return -1;
+
+    // Views handed out by next_message() are only good until now
+    assembled.clear();
+
+    if (current_state == State::Connecting)
+    {
+        // Readable before writable means the connect failed
+        if (on_writable() < 0)
+            return -1;
+    }
+
+    // Anything before rpos has been handed out already
+    if (rpos > 0)
+    {
+        memmove(inbuf.data(), inbuf.data() + rpos, wpos - rpos);
+        wpos -= rpos;
+        rpos = 0;
+    }
+
+    while (true)
+    {
+        if (wpos == inbuf.size())
+        {
+            // Caller has to drain messages and call again before more can be read
+            if (current_state == State::Handshaking && parse_handshake() < 0)
+                return -1;
+            return 1;
+        }
+
+        ssize_t received = ::recv(sockfd, inbuf.data() + wpos, inbuf.size() - wpos, 0);
+        if (received > 0)
+        {
+            wpos += static_cast<size_t>(received);
+            last_receive = std::chrono::steady_clock::now();
+            continue;
+        }
+        if (received == 0)
+        {
+            std::cerr << "recv(" << request_host << "): connection closed by peer" << std::endl;
+            return fail();
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+            break;
+        if (errno == EINTR)
+            continue;
+
+        std::cerr << "recv(" << request_host << "): " << strerror(errno) << std::endl;
+        return fail();
+    }
+
+    if (current_state == State::Handshaking)
+        return parse_handshake();
+
+    return 0;
+}
+
+int WebSocket::parse_handshake()
+{
+    std::string_view headers(inbuf.data(), wpos);
+    size_t end = headers.find("\r\n\r\n");
+    if (end == std::string_view::npos)
+    {
+        if (wpos == inbuf.size())
+        {
+            std::cerr << "Websocket handshake response from " << request_host << " is too large" << std::endl;
+            return fail();
+        }
+        return 0;
+    }
+    headers = headers.substr(0, end + 2);
+
+    if (headers.compare(0, 12, "HTTP/1.1 101") != 0)
+    {
+        std::cerr << "Websocket upgrade rejected by " << request_host << ": "
+                  << headers.substr(0, std::min(headers.find("\r\n"), headers.size())) << std::endl;
+        return fail();
+    }
+
+    const char * accept = find_header(headers, "Sec-WebSocket-Accept");
+    if (!accept || strncmp(accept, expected_accept.c_str(), expected_accept.size()) != 0)
+    {
+        std::cerr << "Websocket handshake from " << request_host << " has an invalid Sec-WebSocket-Accept" << std::endl;
+        return fail();
+    }
+
+    rpos          = end + 4;
+    current_state = State::Open;
+    return 0;
+}
+
+bool WebSocket::next_message(std::string_view & message)
+{
+    while (current_state == State::Open)
+    {
+        size_t available = wpos - rpos;
+        if (available < 2)
+            return false;
+
+        auto * frame      = reinterpret_cast<const uint8_t *>(inbuf.data() + rpos);
+        bool fin          = frame[0] & FLAG_FIN;
+        uint8_t opcode    = frame[0] & 0x0F;
+        bool masked       = frame[1] & FLAG_MASK;
+        uint64_t length   = frame[1] & 0x7F;
+        size_t header_len = 2;
+
+        if (length == 126)
+        {
+            if (available < 4)
+                return false;
+            length     = (static_cast<uint64_t>(frame[2]) << 8) | frame[3];
+            header_len = 4;
+        }
+        else if (length == 127)
+        {
+            if (available < 10)
+                return false;
+            length = 0;
+            for (int i = 0; i < 8; i++)
+                length = (length << 8) | frame[2 + i];
+            header_len = 10;
+        }
+
+        if (length > max_message)
+        {
+            std::cerr << "Websocket frame from " << request_host << " is too large: " << length << " bytes" << std::endl;
+            fail();
+            return false;
+        }
+
+        const uint8_t * mask = nullptr;
+        if (masked)
+        {
+            mask = frame + header_len;
+            header_len += 4;
+        }
+
+        if (available < header_len + length)
+            return false;
+
+        char * payload = inbuf.data() + rpos + header_len;
+        size_t size    = static_cast<size_t>(length);
+        rpos += header_len + size;
+
+        // Servers must not mask, but there is no harm in accepting it
+        if (mask)
+            for (size_t i = 0; i < size; i++)
+                payload[i] = static_cast<char>(payload[i] ^ mask[i % 4]);
+
+        switch (opcode)
+        {
+        case OPCODE_PING:
+            if (size > MAX_CONTROL_BYTES || send_frame(OPCODE_PONG, payload, size) < 0)
+                return false;
+            break;
+        case OPCODE_PONG:
+            break;
+        case OPCODE_CLOSE:
+            std::cerr << "Websocket was closed by " << request_host << std::endl;
+            close();
+            return false;
+        case OPCODE_TEXT:
+        case OPCODE_BINARY:
+            // RFC 6455 5.4: a fragmented message can't be interleaved with another data message
+            if (fragmenting)
+            {
+                std::cerr << "Websocket message from " << request_host << " started inside a fragmented one" << std::endl;
+                fail();
+                return false;
+            }
+            if (fin)
+            {
+                message = std::string_view(payload, size);
+                return true;
+            }
+            fragmenting = true;
+            fragments.assign(payload, payload + size);
+            break;
+        case OPCODE_CONTINUATION:
+            if (!fragmenting)
+            {
+                std::cerr << "Websocket continuation from " << request_host << " without a message to continue" << std::endl;
+                fail();
+                return false;
+            }
+            if (fragments.size() + size > max_message)
+            {
+                std::cerr << "Fragmented websocket message from " << request_host << " is too large" << std::endl;
+                fail();
+                return false;
+            }
+            fragments.insert(fragments.end(), payload, payload + size);
+            if (fin)
+            {
+                // Moved out so the next fragmented message can't overwrite it, the buffer itself doesn't move
+                fragmenting = false;
+                assembled.push_back(std::move(fragments));
+                fragments.clear();
+                message = std::string_view(assembled.back().data(), assembled.back().size());
+                return true;
+            }
+            break;
+        default:
+            std::cerr << "Unknown websocket opcode from " << request_host << ": " << static_cast<int>(opcode) << std::endl;
+            fail();
+            return false;
+        }
+    }
+
+    return false;
+}
+
+int WebSocket::send_text(const char * data, size_t length)
+{
+    return send_frame(OPCODE_TEXT, data, length);
+}
+
+int WebSocket::send_ping()
+{
+    return send_frame(OPCODE_PING, nullptr, 0);
+}
+
+int WebSocket::send_frame(uint8_t opcode, const char * data, size_t length)
+{
+    if (current_state != State::Open)
+        return -1;
+
+    uint8_t header[MAX_HEADER_BYTES];
+    size_t header_len = 0;
+
+    header[header_len++] = static_cast<uint8_t>(FLAG_FIN | opcode);
+    if (length < 126)
+    {
+        header[header_len++] = static_cast<uint8_t>(FLAG_MASK | length);
+    }
+    else if (length <= 0xFFFF)
+    {
+        header[header_len++] = FLAG_MASK | 126;
+        header[header_len++] = static_cast<uint8_t>(length >> 8);
+        header[header_len++] = static_cast<uint8_t>(length);
+    }
+    else
+    {
+        header[header_len++] = FLAG_MASK | 127;
+        for (int i = 7; i >= 0; i--)
+            header[header_len++] = static_cast<uint8_t>(static_cast<uint64_t>(length) >> (8 * i));
+    }
+
+    // xorshift32, client masks only need to be unpredictable to intermediaries
+    mask_state ^= mask_state << 13;
+    mask_state ^= mask_state >> 17;
+    mask_state ^= mask_state << 5;
+    uint8_t mask[4];
+    memcpy(mask, &mask_state, sizeof(mask));
+    for (auto byte : mask)
+        header[header_len++] = byte;
+
+    size_t start = outbuf.size();
+    outbuf.resize(start + header_len + length);
+    memcpy(outbuf.data() + start, header, header_len);
+    char * payload = outbuf.data() + start + header_len;
+    for (size_t i = 0; i < length; i++)
+        payload[i] = static_cast<char>(data[i] ^ mask[i % 4]);
+
+    return flush();
+}
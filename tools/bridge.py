@@ -15,6 +15,7 @@ def main() -> None:
     add_parser = subparsers.add_parser("add")
     remove_parser = subparsers.add_parser("remove")
     qr_parser = subparsers.add_parser("qr")
+    trace_parser = subparsers.add_parser("trace")
 
     for subparser in [add_parser, remove_parser]:
         subparser.add_argument("device", help="ip or hostname", type=str)
@@ -27,6 +28,8 @@ def main() -> None:
         action = "2"
     if args.action == "qr":
         action = "3"
+    if args.action == "trace":
+        action = "4"
 
     with open(WLED_FIFO_IN, "w") as fp:
         fp.write(action)
@@ -51,6 +54,8 @@ def main() -> None:
             print(data)
             result = subprocess.run([Path(sys.executable).parent / "qr", "--ascii", data], stdout=subprocess.PIPE)
             print(result.stdout.decode())
+        if args.action in ["trace"]:
+            print(data, end="")
             
 
 if __name__ == "__main__":